@@ -0,0 +1,443 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <cstdint>
+
+#include "LCN_Collisions/Source/Shapes/AABB.h"
+#include "LCN_Collisions/Source/Shapes/Line.h"
+#include "LCN_Collisions/Source/Memory/Allocator.h"
+
+namespace LCN
+{
+	////////////////////
+	//-- Binary BVH --//
+	////////////////////
+
+	// Compact binary BVH over primitive boxes, built with binned SAH.
+	// Nodes are stored depth first : the left child of an internal node is the next
+	// node, the right child index is stored in the node. Primitives are not stored,
+	// Indices() gives the order in which the caller should lay them out so that
+	// every leaf references a contiguous range.
+	template<typename T, size_t Dim, class Allocator = std::allocator<T>>
+	class BVH
+	{
+	public:
+		using ValType       = T;
+		using AABBType      = AABB<ValType, Dim>;
+		using LineType      = Line<ValType, Dim>;
+		using AllocatorType = Allocator;
+
+		struct Node
+		{
+			ValType  Min[Dim];
+			ValType  Max[Dim];
+			uint32_t Offset; // Leaf : first primitive, internal node : right child
+			uint32_t Count;  // 0 for internal nodes
+
+			bool IsLeaf() const { return Count != 0; }
+		};
+
+		enum : size_t
+		{
+			MaxDepth = 64,
+			NumBins  = 16
+		};
+
+		using NodeArray  = AllocVector<Node, Allocator>;
+		using IndexArray = AllocVector<uint32_t, Allocator>;
+
+		explicit BVH(const Allocator& alloc = Allocator()) :
+			m_Nodes(alloc),
+			m_Indices(alloc),
+			m_PrimBounds(alloc),
+			m_Centroids(alloc)
+		{}
+
+		template<class BoxAllocator>
+		BVH(const std::vector<AABBType, BoxAllocator>& boxes, size_t maxLeafSize = 4, const Allocator& alloc = Allocator()) :
+			BVH(alloc)
+		{
+			Build(boxes.data(), boxes.size(), maxLeafSize);
+		}
+
+		template<class BoxAllocator>
+		void Build(const std::vector<AABBType, BoxAllocator>& boxes, size_t maxLeafSize = 4) { Build(boxes.data(), boxes.size(), maxLeafSize); }
+
+		void Build(const AABBType* boxes, size_t count, size_t maxLeafSize = 4);
+
+		bool Empty() const { return m_Nodes.empty(); }
+
+		const NodeArray&  Nodes()   const { return m_Nodes; }
+		const IndexArray& Indices() const { return m_Indices; }
+
+		// Visits the leaves hit by the line within [tmin, tmax], near child first.
+		// leaf(first, count, tmax) may shrink tmax (closest hit queries) and returns false to stop.
+		template<class LeafFunc>
+		void Traverse(const LineType& line, ValType tmin, ValType tmax, LeafFunc&& leaf) const;
+
+		// Visits the leaves whose bounds overlap the box.
+		// leaf(first, count) returns false to stop.
+		template<class LeafFunc>
+		void Traverse(const AABBType& box, LeafFunc&& leaf) const;
+
+	private:
+		struct Bounds
+		{
+			ValType Min[Dim];
+			ValType Max[Dim];
+
+			Bounds()
+			{
+				for (size_t i = 0; i < Dim; ++i)
+				{
+					Min[i] =  std::numeric_limits<ValType>::max();
+					Max[i] = -std::numeric_limits<ValType>::max();
+				}
+			}
+
+			void Grow(const ValType* min, const ValType* max)
+			{
+				for (size_t i = 0; i < Dim; ++i)
+				{
+					Min[i] = std::min(Min[i], min[i]);
+					Max[i] = std::max(Max[i], max[i]);
+				}
+			}
+
+			// Surface measure used by the SAH (perimeter in 2D, half area in 3D...)
+			ValType Measure() const
+			{
+				if (Min[0] > Max[0])
+					return ValType(0);
+
+				if constexpr (Dim == 1)
+					return Max[0] - Min[0];
+				else if constexpr (Dim == 2)
+					return (Max[0] - Min[0]) + (Max[1] - Min[1]);
+				else
+				{
+					ValType result = 0;
+
+					for (size_t i = 0; i < Dim; ++i)
+						for (size_t j = i + 1; j < Dim; ++j)
+							result += (Max[i] - Min[i]) * (Max[j] - Min[j]);
+
+					return result;
+				}
+			}
+		};
+
+		void BuildNode(size_t nodeIdx, size_t begin, size_t end, size_t depth);
+
+		NodeArray  m_Nodes;
+		IndexArray m_Indices;
+
+		// Build scratch
+		AllocVector<Bounds, Allocator>                   m_PrimBounds;
+		AllocVector<std::array<ValType, Dim>, Allocator> m_Centroids;
+		size_t                                           m_MaxLeafSize = 4;
+	};
+
+	////////////////////////
+	//-- Implementation --//
+	////////////////////////
+
+	template<typename T, size_t Dim, class Allocator>
+	inline void BVH<T, Dim, Allocator>::Build(const AABBType* boxes, size_t count, size_t maxLeafSize)
+	{
+		m_Nodes.clear();
+		m_Indices.resize(count);
+		std::iota(m_Indices.begin(), m_Indices.end(), uint32_t(0));
+
+		if (count == 0)
+			return;
+
+		m_MaxLeafSize = std::max(maxLeafSize, size_t(1));
+
+		m_PrimBounds.resize(count);
+		m_Centroids.resize(count);
+
+		for (size_t p = 0; p < count; ++p)
+		{
+			for (size_t i = 0; i < Dim; ++i)
+			{
+				m_PrimBounds[p].Min[i] = boxes[p].Min()[i];
+				m_PrimBounds[p].Max[i] = boxes[p].Max()[i];
+				m_Centroids[p][i]      = (boxes[p].Min()[i] + boxes[p].Max()[i]) / ValType(2);
+			}
+		}
+
+		m_Nodes.reserve(2 * count / m_MaxLeafSize + 1);
+		m_Nodes.emplace_back();
+
+		BuildNode(0, 0, count, 0);
+
+		// Capacity is kept for the next build
+		m_PrimBounds.clear();
+		m_Centroids.clear();
+	}
+
+	template<typename T, size_t Dim, class Allocator>
+	inline void BVH<T, Dim, Allocator>::BuildNode(size_t nodeIdx, size_t begin, size_t end, size_t depth)
+	{
+		Bounds bounds, centroidBounds;
+
+		for (size_t k = begin; k < end; ++k)
+		{
+			const uint32_t p = m_Indices[k];
+
+			bounds.Grow(m_PrimBounds[p].Min, m_PrimBounds[p].Max);
+			centroidBounds.Grow(m_Centroids[p].data(), m_Centroids[p].data());
+		}
+
+		for (size_t i = 0; i < Dim; ++i)
+		{
+			m_Nodes[nodeIdx].Min[i] = bounds.Min[i];
+			m_Nodes[nodeIdx].Max[i] = bounds.Max[i];
+		}
+
+		const size_t count = end - begin;
+
+		auto makeLeaf = [&]()
+		{
+			m_Nodes[nodeIdx].Offset = uint32_t(begin);
+			m_Nodes[nodeIdx].Count  = uint32_t(count);
+		};
+
+		if (count <= m_MaxLeafSize || depth + 1 >= MaxDepth)
+			return makeLeaf();
+
+		size_t axis = 0;
+		for (size_t i = 1; i < Dim; ++i)
+			if (centroidBounds.Max[i] - centroidBounds.Min[i] > centroidBounds.Max[axis] - centroidBounds.Min[axis])
+				axis = i;
+
+		const ValType cmin   = centroidBounds.Min[axis];
+		const ValType extent = centroidBounds.Max[axis] - cmin;
+
+		size_t mid = begin;
+
+		if (extent > ValType(0))
+		{
+			// Binned SAH
+			std::array<Bounds, NumBins> binBounds;
+			std::array<size_t, NumBins> binCounts{};
+
+			const ValType scale = ValType(NumBins) / extent;
+
+			auto binOf = [&](uint32_t p)
+			{
+				size_t b = size_t((m_Centroids[p][axis] - cmin) * scale);
+				return std::min(b, size_t(NumBins - 1));
+			};
+
+			for (size_t k = begin; k < end; ++k)
+			{
+				const uint32_t p = m_Indices[k];
+				const size_t   b = binOf(p);
+
+				binBounds[b].Grow(m_PrimBounds[p].Min, m_PrimBounds[p].Max);
+				++binCounts[b];
+			}
+
+			std::array<ValType, NumBins - 1> leftCost;
+			Bounds leftBounds;
+			size_t leftCount = 0;
+
+			for (size_t b = 0; b < NumBins - 1; ++b)
+			{
+				leftBounds.Grow(binBounds[b].Min, binBounds[b].Max);
+				leftCount += binCounts[b];
+				leftCost[b] = leftBounds.Measure() * ValType(leftCount);
+			}
+
+			Bounds rightBounds;
+			size_t rightCount = 0;
+			size_t bestSplit  = 0;
+			ValType bestCost  = std::numeric_limits<ValType>::max();
+
+			for (size_t b = NumBins - 1; b > 0; --b)
+			{
+				rightBounds.Grow(binBounds[b].Min, binBounds[b].Max);
+				rightCount += binCounts[b];
+
+				ValType cost = leftCost[b - 1] + rightBounds.Measure() * ValType(rightCount);
+
+				if (cost < bestCost)
+				{
+					bestCost  = cost;
+					bestSplit = b;
+				}
+			}
+
+			auto it = std::partition(m_Indices.begin() + begin, m_Indices.begin() + end, [&](uint32_t p) { return binOf(p) < bestSplit; });
+
+			mid = size_t(it - m_Indices.begin());
+		}
+
+		// Degenerate split (identical centroids...) : median split
+		if (mid == begin || mid == end)
+		{
+			mid = begin + count / 2;
+
+			std::nth_element(m_Indices.begin() + begin, m_Indices.begin() + mid, m_Indices.begin() + end,
+				[&](uint32_t a, uint32_t b) { return m_Centroids[a][axis] < m_Centroids[b][axis]; });
+		}
+
+		m_Nodes[nodeIdx].Count = 0;
+
+		const size_t leftIdx = m_Nodes.size();
+		m_Nodes.emplace_back();
+		BuildNode(leftIdx, begin, mid, depth + 1);
+
+		const size_t rightIdx = m_Nodes.size();
+		m_Nodes.emplace_back();
+		m_Nodes[nodeIdx].Offset = uint32_t(rightIdx);
+		BuildNode(rightIdx, mid, end, depth + 1);
+	}
+
+	template<typename T, size_t Dim, class Allocator>
+	template<class LeafFunc>
+	inline void BVH<T, Dim, Allocator>::Traverse(const LineType& line, ValType tmin, ValType tmax, LeafFunc&& leaf) const
+	{
+		if (m_Nodes.empty())
+			return;
+
+		ValType origin[Dim], invDir[Dim];
+
+		for (size_t i = 0; i < Dim; ++i)
+		{
+			origin[i] = line.Origin()[i];
+			invDir[i] = ValType(1) / line.Direction()[i];
+		}
+
+		// Entry distance of the line in a node, infinity if missed
+		auto entry = [&](const Node& node)
+		{
+			ValType tnear = tmin;
+			ValType tfar  = tmax;
+
+			for (size_t i = 0; i < Dim; ++i)
+			{
+				ValType t1 = (node.Min[i] - origin[i]) * invDir[i];
+				ValType t2 = (node.Max[i] - origin[i]) * invDir[i];
+
+				tnear = std::max(tnear, std::min(t1, t2));
+				tfar  = std::min(tfar,  std::max(t1, t2));
+			}
+
+			return tnear <= tfar ? tnear : std::numeric_limits<ValType>::infinity();
+		};
+
+		// A node to visit and the entry distance of the line in it
+		struct Entry
+		{
+			uint32_t Node;
+			ValType  Distance;
+		};
+
+		std::array<Entry, MaxDepth> stack;
+		size_t top = 0;
+
+		const ValType troot = entry(m_Nodes[0]);
+
+		if (troot == std::numeric_limits<ValType>::infinity())
+			return;
+
+		stack[top++] = Entry{ 0, troot };
+
+		while (top > 0)
+		{
+			const Entry current = stack[--top];
+
+			// tmax may have shrunk since the node was pushed
+			if (current.Distance > tmax)
+				continue;
+
+			const Node& node = m_Nodes[current.Node];
+
+			if (node.IsLeaf())
+			{
+				if (!leaf(node.Offset, node.Count, tmax))
+					return;
+
+				continue;
+			}
+
+			uint32_t left  = current.Node + 1;
+			uint32_t right = node.Offset;
+
+			ValType tleft  = entry(m_Nodes[left]);
+			ValType tright = entry(m_Nodes[right]);
+
+			if (tleft > tright)
+			{
+				std::swap(left, right);
+				std::swap(tleft, tright);
+			}
+
+			// Far child first so that the near child is popped first
+			if (tright != std::numeric_limits<ValType>::infinity())
+				stack[top++] = Entry{ right, tright };
+
+			if (tleft != std::numeric_limits<ValType>::infinity())
+				stack[top++] = Entry{ left, tleft };
+		}
+	}
+
+	template<typename T, size_t Dim, class Allocator>
+	template<class LeafFunc>
+	inline void BVH<T, Dim, Allocator>::Traverse(const AABBType& box, LeafFunc&& leaf) const
+	{
+		if (m_Nodes.empty())
+			return;
+
+		auto overlaps = [&](const Node& node)
+		{
+			for (size_t i = 0; i < Dim; ++i)
+				if (node.Min[i] > box.Max()[i] || node.Max[i] < box.Min()[i])
+					return false;
+
+			return true;
+		};
+
+		std::array<uint32_t, MaxDepth> stack;
+		size_t top = 0;
+
+		if (!overlaps(m_Nodes[0]))
+			return;
+
+		stack[top++] = 0;
+
+		while (top > 0)
+		{
+			const uint32_t idx  = stack[--top];
+			const Node&    node = m_Nodes[idx];
+
+			if (node.IsLeaf())
+			{
+				if (!leaf(node.Offset, node.Count))
+					return;
+
+				continue;
+			}
+
+			if (overlaps(m_Nodes[node.Offset]))
+				stack[top++] = node.Offset;
+
+			if (overlaps(m_Nodes[idx + 1]))
+				stack[top++] = idx + 1;
+		}
+	}
+
+	////////////////////////
+	//-- Shortcut types --//
+	////////////////////////
+
+	using BVH2Df = BVH<float, 2>;
+	using BVH3Df = BVH<float, 3>;
+}
@@ -0,0 +1,383 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+
+#include "LCN_Collisions/Source/Acceleration/BVH.h"
+#include "LCN_Collisions/Source/Core/Bits.h"
+#include "LCN_Collisions/Source/Memory/Allocator.h"
+
+namespace LCN
+{
+	//////////////////
+	//-- Wide BVH --//
+	//////////////////
+
+	// BVH with Width (4 or 8) children per node, obtained by collapsing a binary BVH.
+	// The bounds of the children are stored as structure of arrays in the node, so one
+	// node fetch tests every child against a line or a box with branch-free lane loops.
+	// A node is aligned on a cache line, 4 children of a 3D float tree fill two.
+	// Leaves are not nodes : a child slot references either a node or a range of
+	// primitives, which follow the order given by Indices() like in the binary BVH.
+	template<typename T, size_t Dim, size_t Width = 4, class Allocator = std::allocator<T>>
+	class WideBVH
+	{
+	public:
+		static_assert(Width == 4 || Width == 8, "WideBVH nodes have 4 or 8 children");
+
+		using ValType       = T;
+		using AABBType      = AABB<ValType, Dim>;
+		using LineType      = Line<ValType, Dim>;
+		using AllocatorType = Allocator;
+		using BinaryBVHType = BVH<ValType, Dim, Allocator>;
+
+		static constexpr uint32_t NoChild = std::numeric_limits<uint32_t>::max();
+
+		struct alignas(64) Node
+		{
+			ValType  Min[Dim][Width];
+			ValType  Max[Dim][Width];
+			uint32_t Child[Width]; // Leaf : first primitive, internal node : node index, NoChild for empty slots
+			uint32_t Count[Width]; // Number of primitives, 0 for internal nodes and empty slots
+
+			bool IsLeaf(size_t j) const { return Count[j] != 0; }
+		};
+
+		enum : size_t
+		{
+			MaxDepth  = BinaryBVHType::MaxDepth,
+			StackSize = MaxDepth * (Width - 1) + 1
+		};
+
+		using NodeArray  = AllocVector<Node, Allocator>;
+		using IndexArray = AllocVector<uint32_t, Allocator>;
+
+		explicit WideBVH(const Allocator& alloc = Allocator()) :
+			m_Allocator(alloc),
+			m_Nodes(alloc),
+			m_Indices(alloc)
+		{}
+
+		template<class BoxAllocator>
+		WideBVH(const std::vector<AABBType, BoxAllocator>& boxes, size_t maxLeafSize = 4, const Allocator& alloc = Allocator()) :
+			WideBVH(alloc)
+		{
+			Build(boxes.data(), boxes.size(), maxLeafSize);
+		}
+
+		template<class BoxAllocator>
+		void Build(const std::vector<AABBType, BoxAllocator>& boxes, size_t maxLeafSize = 4) { Build(boxes.data(), boxes.size(), maxLeafSize); }
+
+		// Builds a temporary binary BVH and collapses it
+		void Build(const AABBType* boxes, size_t count, size_t maxLeafSize = 4);
+
+		// Converts any binary BVH, primitives keep the order of bvh.Indices()
+		template<class BVHAllocator>
+		void Collapse(const BVH<ValType, Dim, BVHAllocator>& bvh);
+
+		bool Empty() const { return m_Nodes.empty(); }
+
+		const NodeArray&  Nodes()   const { return m_Nodes; }
+		const IndexArray& Indices() const { return m_Indices; }
+
+		// Same contracts as BVH::Traverse. Children hit by the line are visited near to far.
+		template<class LeafFunc>
+		void Traverse(const LineType& line, ValType tmin, ValType tmax, LeafFunc&& leaf) const;
+
+		template<class LeafFunc>
+		void Traverse(const AABBType& box, LeafFunc&& leaf) const;
+
+	private:
+		template<class BinaryNode>
+		uint32_t CollapseNode(const BinaryNode* nodes, uint32_t idx);
+
+		Allocator  m_Allocator;
+		NodeArray  m_Nodes;
+		IndexArray m_Indices;
+	};
+
+	////////////////////////
+	//-- Implementation --//
+	////////////////////////
+
+	template<typename T, size_t Dim, size_t Width, class Allocator>
+	inline void WideBVH<T, Dim, Width, Allocator>::Build(const AABBType* boxes, size_t count, size_t maxLeafSize)
+	{
+		BinaryBVHType binary(m_Allocator);
+		binary.Build(boxes, count, maxLeafSize);
+
+		Collapse(binary);
+	}
+
+	template<typename T, size_t Dim, size_t Width, class Allocator>
+	template<class BVHAllocator>
+	inline void WideBVH<T, Dim, Width, Allocator>::Collapse(const BVH<ValType, Dim, BVHAllocator>& bvh)
+	{
+		m_Nodes.clear();
+		m_Indices.assign(bvh.Indices().begin(), bvh.Indices().end());
+
+		if (bvh.Empty())
+			return;
+
+		const auto& nodes = bvh.Nodes();
+
+		// At most one wide node per internal binary node
+		m_Nodes.reserve(nodes.size() / 2 + 1);
+
+		CollapseNode(nodes.data(), 0);
+	}
+
+	template<typename T, size_t Dim, size_t Width, class Allocator>
+	template<class BinaryNode>
+	inline uint32_t WideBVH<T, Dim, Width, Allocator>::CollapseNode(const BinaryNode* nodes, uint32_t idx)
+	{
+		auto measure = [&](uint32_t n)
+		{
+			ValType result = 0;
+
+			for (size_t i = 0; i < Dim; ++i)
+				for (size_t k = i + 1; k < Dim; ++k)
+					result += (nodes[n].Max[i] - nodes[n].Min[i]) * (nodes[n].Max[k] - nodes[n].Min[k]);
+
+			return Dim == 1 ? nodes[n].Max[0] - nodes[n].Min[0] : result;
+		};
+
+		// Children of the wide node : open the largest internal child until Width are gathered
+		std::array<uint32_t, Width> children;
+		size_t numChildren = 0;
+
+		if (nodes[idx].IsLeaf())
+			children[numChildren++] = idx;
+		else
+		{
+			children[numChildren++] = idx + 1;
+			children[numChildren++] = nodes[idx].Offset;
+		}
+
+		while (numChildren < Width)
+		{
+			size_t  best        = Width;
+			ValType bestMeasure = -std::numeric_limits<ValType>::infinity();
+
+			for (size_t j = 0; j < numChildren; ++j)
+			{
+				if (!nodes[children[j]].IsLeaf() && measure(children[j]) > bestMeasure)
+				{
+					best        = j;
+					bestMeasure = measure(children[j]);
+				}
+			}
+
+			if (best == Width)
+				break;
+
+			const uint32_t opened = children[best];
+
+			children[best]          = opened + 1;
+			children[numChildren++] = nodes[opened].Offset;
+		}
+
+		const uint32_t nodeIdx = uint32_t(m_Nodes.size());
+		m_Nodes.emplace_back();
+
+		for (size_t j = 0; j < Width; ++j)
+		{
+			Node& node = m_Nodes[nodeIdx];
+
+			if (j >= numChildren)
+			{
+				// Masked out by the traversals, the bounds only need to be finite or infinite, not NaN
+				for (size_t i = 0; i < Dim; ++i)
+				{
+					node.Min[i][j] = std::numeric_limits<ValType>::infinity();
+					node.Max[i][j] = std::numeric_limits<ValType>::infinity();
+				}
+
+				node.Child[j] = NoChild;
+				node.Count[j] = 0;
+
+				continue;
+			}
+
+			const BinaryNode& child = nodes[children[j]];
+
+			for (size_t i = 0; i < Dim; ++i)
+			{
+				node.Min[i][j] = child.Min[i];
+				node.Max[i][j] = child.Max[i];
+			}
+
+			node.Count[j] = child.Count;
+			node.Child[j] = child.IsLeaf() ? child.Offset : NoChild;
+
+			// m_Nodes may be reallocated by the recursion
+			if (!child.IsLeaf())
+			{
+				const uint32_t childIdx = CollapseNode(nodes, children[j]);
+
+				m_Nodes[nodeIdx].Child[j] = childIdx;
+			}
+		}
+
+		return nodeIdx;
+	}
+
+	template<typename T, size_t Dim, size_t Width, class Allocator>
+	template<class LeafFunc>
+	inline void WideBVH<T, Dim, Width, Allocator>::Traverse(const LineType& line, ValType tmin, ValType tmax, LeafFunc&& leaf) const
+	{
+		if (m_Nodes.empty())
+			return;
+
+		ValType origin[Dim], invDir[Dim];
+
+		for (size_t i = 0; i < Dim; ++i)
+		{
+			origin[i] = line.Origin()[i];
+			invDir[i] = ValType(1) / line.Direction()[i];
+		}
+
+		// A child to visit, Count != 0 for leaves
+		struct Entry
+		{
+			uint32_t Child;
+			uint32_t Count;
+			ValType  Distance;
+		};
+
+		std::array<Entry, StackSize> stack;
+		size_t top = 0;
+
+		stack[top++] = Entry{ 0, 0, tmin };
+
+		while (top > 0)
+		{
+			const Entry entry = stack[--top];
+
+			// tmax may have shrunk since the child was pushed
+			if (entry.Distance > tmax)
+				continue;
+
+			if (entry.Count != 0)
+			{
+				if (!leaf(entry.Child, entry.Count, tmax))
+					return;
+
+				continue;
+			}
+
+			const Node& node = m_Nodes[entry.Child];
+
+			ValType tnear[Width], tfar[Width];
+
+			for (size_t j = 0; j < Width; ++j)
+			{
+				tnear[j] = tmin;
+				tfar[j]  = tmax;
+			}
+
+			for (size_t i = 0; i < Dim; ++i)
+			{
+				for (size_t j = 0; j < Width; ++j)
+				{
+					ValType t1 = (node.Min[i][j] - origin[i]) * invDir[i];
+					ValType t2 = (node.Max[i][j] - origin[i]) * invDir[i];
+
+					tnear[j] = std::max(tnear[j], std::min(t1, t2));
+					tfar[j]  = std::min(tfar[j],  std::max(t1, t2));
+				}
+			}
+
+			uint32_t mask = 0;
+
+			for (size_t j = 0; j < Width; ++j)
+				mask |= uint32_t((tnear[j] <= tfar[j]) & (node.Child[j] != NoChild)) << j;
+
+			// Hit children sorted far to near, so that the nearest is popped first
+			std::array<Entry, Width> hits;
+			size_t numHits = 0;
+
+			ForEachSetBit(mask, [&](uint32_t j)
+			{
+				Entry hit{ node.Child[j], node.Count[j], tnear[j] };
+
+				size_t k = numHits++;
+
+				for (; k > 0 && hits[k - 1].Distance < hit.Distance; --k)
+					hits[k] = hits[k - 1];
+
+				hits[k] = hit;
+			});
+
+			for (size_t k = 0; k < numHits; ++k)
+				stack[top++] = hits[k];
+		}
+	}
+
+	template<typename T, size_t Dim, size_t Width, class Allocator>
+	template<class LeafFunc>
+	inline void WideBVH<T, Dim, Width, Allocator>::Traverse(const AABBType& box, LeafFunc&& leaf) const
+	{
+		if (m_Nodes.empty())
+			return;
+
+		ValType boxMin[Dim], boxMax[Dim];
+
+		for (size_t i = 0; i < Dim; ++i)
+		{
+			boxMin[i] = box.Min()[i];
+			boxMax[i] = box.Max()[i];
+		}
+
+		std::array<uint32_t, StackSize> stack;
+		size_t top = 0;
+
+		stack[top++] = 0;
+
+		while (top > 0)
+		{
+			const Node& node = m_Nodes[stack[--top]];
+
+			uint32_t mask = 0;
+
+			for (size_t j = 0; j < Width; ++j)
+				mask |= uint32_t(node.Child[j] != NoChild) << j;
+
+			for (size_t i = 0; i < Dim; ++i)
+			{
+				uint32_t axisMask = 0;
+
+				for (size_t j = 0; j < Width; ++j)
+					axisMask |= uint32_t((node.Min[i][j] <= boxMax[i]) & (boxMin[i] <= node.Max[i][j])) << j;
+
+				mask &= axisMask;
+			}
+
+			bool more = true;
+
+			ForEachSetBit(mask, [&](uint32_t j)
+			{
+				if (!more)
+					return;
+
+				if (node.IsLeaf(j))
+					more = leaf(node.Child[j], node.Count[j]);
+				else
+					stack[top++] = node.Child[j];
+			});
+
+			if (!more)
+				return;
+		}
+	}
+
+	////////////////////////
+	//-- Shortcut types --//
+	////////////////////////
+
+	using WideBVH4_3Df = WideBVH<float, 3, 4>;
+	using WideBVH8_3Df = WideBVH<float, 3, 8>;
+}
@@ -0,0 +1,522 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <istream>
+#include <ostream>
+#include <filesystem>
+#include <queue>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <limits>
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <system_error>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "LCN_Collisions/Source/Collisions/CollisionAlgorithms.h"
+#include "LCN_Collisions/Source/Concurrency/ParallelFor.h"
+#include "LCN_Collisions/Source/IO/RecordFile.h"
+
+namespace LCN
+{
+	////////////////////
+	//-- Box record --//
+	////////////////////
+
+	// On disk form of a box, the layout of the input and temporary files
+	template<typename T, size_t Dim>
+	struct BoxRecord
+	{
+		T        Min[Dim];
+		T        Max[Dim];
+		uint32_t Id;
+
+		AABB<T, Dim> Box() const
+		{
+			VectorND<T, Dim> min, max;
+
+			for (size_t i = 0; i < Dim; ++i)
+			{
+				min[i] = Min[i];
+				max[i] = Max[i];
+			}
+
+			return AABB<T, Dim>(min, max);
+		}
+	};
+
+	// Appends boxes to a binary stream readable by BoxIntersection::Run, ids start at firstId
+	template<typename T, size_t Dim>
+	inline void
+	WriteBoxRecords(
+		std::ostream& stream,
+		const AABB<T, Dim>* boxes,
+		size_t count,
+		uint32_t firstId = 0)
+	{
+		for (size_t k = 0; k < count; ++k)
+		{
+			BoxRecord<T, Dim> record;
+
+			for (size_t i = 0; i < Dim; ++i)
+			{
+				record.Min[i] = boxes[k].Min()[i];
+				record.Max[i] = boxes[k].Max()[i];
+			}
+
+			record.Id = firstId + uint32_t(k);
+
+			stream.write(reinterpret_cast<const char*>(&record), sizeof(record));
+		}
+	}
+
+	//////////////////////////
+	//-- Box intersection --//
+	//////////////////////////
+
+	// Complete intersection of a set of boxes too large to be held in memory, reported
+	// as AABBVSAABB results. Only the boxes crossing the sweep line of one slab per
+	// thread are held in memory at any time.
+	//  1. The input is read in runs of RunSize boxes, each run is sorted on the first axis
+	//     and spilled to a temporary file.
+	//  2. The runs are merged and the boxes are distributed to NumSlabs slabs along the
+	//     first axis, a box going to every slab it spans. Slab bounds are quantiles of
+	//     samples taken from the sorted runs.
+	//  3. The slabs are swept in parallel. A pair is reported by the slab holding the
+	//     largest of the two minimum coordinates on the first axis, hence exactly once.
+	// Like ComputeCollision, boxes that only touch do not intersect. Pairs are reported
+	// as (id1, id2) with id1 the box of smaller minimum on the first axis.
+	// I/O errors are reported by the Result of the returned Stats. An exception thrown by
+	// the sink or the source stops the run and is rethrown by Run, temporary files are
+	// removed in every case.
+	template<typename T, size_t Dim>
+	class BoxIntersection
+	{
+	public:
+		using ValType    = T;
+		using RecordType = BoxRecord<ValType, Dim>;
+		using ResultType = AABBVSAABB<ValType, Dim>;
+
+		struct Parameters
+		{
+			std::filesystem::path TempDirectory = std::filesystem::temp_directory_path();
+
+			size_t RunSize         = size_t(1) << 22;        // Boxes sorted in memory at once
+			size_t NumSlabs        = 4 * HardwareThreads();  // More slabs than threads balances skewed inputs
+			size_t SamplesPerRun   = 1024;
+			size_t RecordsInBuffer = size_t(1) << 14;        // Size of the buffer of each open file
+		};
+
+		enum class Status : uint8_t
+		{
+			Success,
+			OpenFailed,  // A temporary file could not be created
+			WriteFailed, // A temporary file could not be written (full disk...)
+			ReadFailed,  // The input stream or a temporary file could not be read
+			RemoveFailed // Every pair was reported but temporary files are left behind
+		};
+
+		struct Stats
+		{
+			Status Result; // The pairs reported are incomplete unless Success or RemoveFailed
+			size_t NumBoxes;
+			size_t NumRuns;
+			size_t NumSlabs;
+			size_t SlabRecords; // Boxes written to slabs, duplicates of boxes spanning several slabs included
+			size_t NumPairs;
+		};
+
+		explicit BoxIntersection(const Parameters& params = Parameters());
+
+		// source is either a binary std::istream of BoxRecord, as written by WriteBoxRecords, or a
+		// function read(RecordType* out, size_t max) returning the number of boxes read, 0 at the end.
+		// sink(slab, id1, id2, result) is called concurrently by the slab threads, never twice at once for the same slab.
+		template<class Source, class Sink>
+		Stats Run(Source&& source, Sink&& sink);
+
+	private:
+		std::filesystem::path TempPath(const char* kind, size_t index) const;
+
+		// Removes the files of the runs and slabs that still exist, false if one could not be removed
+		bool RemoveTempFiles(size_t numRuns) const;
+
+		size_t SlabOf(ValType coord) const;
+
+		template<class Source, class Sink>
+		Stats Process(Source& read, Sink& sink);
+
+		template<class Source, class Sink>
+		void Steps(Source& read, Sink& sink, Stats& stats);
+
+		template<class Sink>
+		Status Sweep(size_t slab, Sink& sink, size_t& numPairs) const;
+
+		Parameters m_Params;
+
+		// Prefix of the temporary files of the current run, unique among the processes sharing TempDirectory
+		std::string m_TempPrefix;
+
+		// Lower bound of each slab on the first axis, m_SlabBounds[0] is -infinity
+		std::vector<ValType> m_SlabBounds;
+	};
+
+	////////////////////////
+	//-- Implementation --//
+	////////////////////////
+
+	template<typename T, size_t Dim>
+	inline BoxIntersection<T, Dim>::BoxIntersection(const Parameters& params) :
+		m_Params(params)
+	{
+		m_Params.RunSize         = std::max<size_t>(m_Params.RunSize, 1);
+		m_Params.NumSlabs        = std::max<size_t>(m_Params.NumSlabs, 1);
+		m_Params.SamplesPerRun   = std::max<size_t>(m_Params.SamplesPerRun, 1);
+		m_Params.RecordsInBuffer = std::max<size_t>(m_Params.RecordsInBuffer, 1);
+	}
+
+	template<typename T, size_t Dim>
+	inline std::filesystem::path BoxIntersection<T, Dim>::TempPath(const char* kind, size_t index) const
+	{
+		return m_Params.TempDirectory / (m_TempPrefix + kind + "_" + std::to_string(index) + ".bin");
+	}
+
+	template<typename T, size_t Dim>
+	inline bool BoxIntersection<T, Dim>::RemoveTempFiles(size_t numRuns) const
+	{
+		bool removed = true;
+
+		auto remove = [&](const std::filesystem::path& path)
+		{
+			std::error_code error;
+
+			std::filesystem::remove(path, error);
+
+			removed &= !error;
+		};
+
+		for (size_t r = 0; r < numRuns; ++r)
+			remove(TempPath("run", r));
+
+		for (size_t s = 0; s < m_Params.NumSlabs; ++s)
+			remove(TempPath("slab", s));
+
+		return removed;
+	}
+
+	template<typename T, size_t Dim>
+	inline size_t BoxIntersection<T, Dim>::SlabOf(ValType coord) const
+	{
+		return size_t(std::upper_bound(m_SlabBounds.begin() + 1, m_SlabBounds.end(), coord) - m_SlabBounds.begin()) - 1;
+	}
+
+	template<typename T, size_t Dim>
+	template<class Source, class Sink>
+	inline typename BoxIntersection<T, Dim>::Stats BoxIntersection<T, Dim>::Run(Source&& source, Sink&& sink)
+	{
+		// Process id and a counter : distinct names for the runs of every instance of every process
+		static std::atomic<uint64_t> counter{ 0 };
+
+#ifdef _WIN32
+		const uint64_t pid = uint64_t(_getpid());
+#else
+		const uint64_t pid = uint64_t(getpid());
+#endif
+
+		m_TempPrefix = "LCN_BoxIntersection_" + std::to_string(pid) + "_" + std::to_string(counter++) + "_";
+
+		if constexpr (std::is_base_of_v<std::istream, std::decay_t<Source>>)
+		{
+			RecordReader<RecordType> reader(source, m_Params.RecordsInBuffer);
+
+			auto read = [&](RecordType* out, size_t max) { return reader.Read(out, max); };
+
+			Stats stats = Process(read, sink);
+
+			if (!reader.Good() && stats.Result == Status::Success)
+				stats.Result = Status::ReadFailed;
+
+			return stats;
+		}
+		else
+			return Process(source, sink);
+	}
+
+	template<typename T, size_t Dim>
+	template<class Source, class Sink>
+	inline typename BoxIntersection<T, Dim>::Stats BoxIntersection<T, Dim>::Process(Source& read, Sink& sink)
+	{
+		Stats stats{ Status::Success, 0, 0, m_Params.NumSlabs, 0, 0 };
+
+		try
+		{
+			Steps(read, sink, stats);
+		}
+		catch (...)
+		{
+			RemoveTempFiles(stats.NumRuns);
+			throw;
+		}
+
+		if (!RemoveTempFiles(stats.NumRuns) && stats.Result == Status::Success)
+			stats.Result = Status::RemoveFailed;
+
+		return stats;
+	}
+
+	template<typename T, size_t Dim>
+	template<class Source, class Sink>
+	inline void BoxIntersection<T, Dim>::Steps(Source& read, Sink& sink, Stats& stats)
+	{
+		auto byMin = [](const RecordType& a, const RecordType& b) { return a.Min[0] < b.Min[0]; };
+
+		// 1. Sorted runs
+		std::vector<ValType> samples;
+
+		{
+			std::vector<RecordType> run(m_Params.RunSize);
+
+			for (;;)
+			{
+				const size_t count = read(run.data(), run.size());
+
+				if (count == 0)
+					break;
+
+				std::sort(run.begin(), run.begin() + count, byMin);
+
+				for (size_t s = 0; s < m_Params.SamplesPerRun; ++s)
+					samples.push_back(run[s * count / m_Params.SamplesPerRun].Min[0]);
+
+				// Counted first so that a file created before a failure is removed
+				++stats.NumRuns;
+
+				RecordWriter<RecordType> writer(TempPath("run", stats.NumRuns - 1).string(), m_Params.RecordsInBuffer);
+				writer.Write(run.data(), count);
+				writer.Flush();
+
+				if (!writer.Good())
+				{
+					stats.Result = writer.IsOpen() ? Status::WriteFailed : Status::OpenFailed;
+					return;
+				}
+
+				stats.NumBoxes += count;
+			}
+		}
+
+		// 2. Slab bounds, then k-way merge of the runs into the slabs
+		std::sort(samples.begin(), samples.end());
+
+		m_SlabBounds.assign(1, -std::numeric_limits<ValType>::infinity());
+
+		for (size_t s = 1; s < m_Params.NumSlabs; ++s)
+			m_SlabBounds.push_back(samples.empty() ? std::numeric_limits<ValType>::infinity() : samples[s * samples.size() / m_Params.NumSlabs]);
+
+		{
+			std::vector<std::unique_ptr<RecordReader<RecordType>>> runs;
+			std::vector<std::unique_ptr<RecordWriter<RecordType>>> slabs;
+
+			for (size_t r = 0; r < stats.NumRuns; ++r)
+			{
+				runs.push_back(std::make_unique<RecordReader<RecordType>>(TempPath("run", r).string(), m_Params.RecordsInBuffer));
+
+				if (!runs.back()->IsOpen())
+				{
+					stats.Result = Status::ReadFailed;
+					return;
+				}
+			}
+
+			for (size_t s = 0; s < m_Params.NumSlabs; ++s)
+			{
+				slabs.push_back(std::make_unique<RecordWriter<RecordType>>(TempPath("slab", s).string(), m_Params.RecordsInBuffer));
+
+				if (!slabs.back()->IsOpen())
+				{
+					stats.Result = Status::OpenFailed;
+					return;
+				}
+			}
+
+			struct Head
+			{
+				RecordType Record;
+				size_t     Run;
+
+				bool operator>(const Head& other) const { return Record.Min[0] > other.Record.Min[0]; }
+			};
+
+			std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+
+			for (size_t r = 0; r < stats.NumRuns; ++r)
+				if (const RecordType* record = runs[r]->Next())
+					heads.push(Head{ *record, r });
+
+			// Slabs receive the boxes sorted on the first axis
+			while (!heads.empty())
+			{
+				const Head head = heads.top();
+				heads.pop();
+
+				const size_t first = SlabOf(head.Record.Min[0]);
+				const size_t last  = SlabOf(head.Record.Max[0]);
+
+				for (size_t s = first; s <= last; ++s)
+					slabs[s]->Write(head.Record);
+
+				stats.SlabRecords += last - first + 1;
+
+				if (const RecordType* record = runs[head.Run]->Next())
+					heads.push(Head{ *record, head.Run });
+			}
+
+			for (auto& run : runs)
+			{
+				if (!run->Good())
+				{
+					stats.Result = Status::ReadFailed;
+					return;
+				}
+			}
+
+			runs.clear();
+
+			// The runs are not needed anymore, leaves room for the slabs on the disk
+			for (size_t r = 0; r < stats.NumRuns; ++r)
+			{
+				std::error_code error;
+				std::filesystem::remove(TempPath("run", r), error);
+			}
+
+			for (auto& slab : slabs)
+			{
+				slab->Flush();
+
+				if (!slab->Good())
+				{
+					stats.Result = Status::WriteFailed;
+					return;
+				}
+			}
+		}
+
+		// 3. Parallel sweeps, every thread takes the next slab when it is done with one
+		std::atomic<size_t>  nextSlab{ 0 };
+		std::atomic<size_t>  numPairs{ 0 };
+		std::atomic<uint8_t> result{ uint8_t(Status::Success) };
+
+		const size_t numThreads = std::min(HardwareThreads(), m_Params.NumSlabs);
+
+		ParallelFor(numThreads, 1, [&](size_t, size_t begin, size_t end)
+		{
+			for (size_t thread = begin; thread < end; ++thread)
+			{
+				for (size_t s = nextSlab++; s < m_Params.NumSlabs; s = nextSlab++)
+				{
+					size_t slabPairs = 0;
+					Status status;
+
+					try
+					{
+						status = Sweep(s, sink, slabPairs);
+					}
+					catch (...)
+					{
+						// No other slab is started, ParallelFor rethrows on the calling thread
+						nextSlab = m_Params.NumSlabs;
+						throw;
+					}
+
+					numPairs += slabPairs;
+
+					if (status != Status::Success)
+					{
+						uint8_t expected = uint8_t(Status::Success);
+						result.compare_exchange_strong(expected, uint8_t(status));
+					}
+
+					std::error_code error;
+					std::filesystem::remove(TempPath("slab", s), error);
+				}
+			}
+		});
+
+		stats.NumPairs = numPairs;
+		stats.Result   = Status(result.load());
+	}
+
+	template<typename T, size_t Dim>
+	template<class Sink>
+	inline typename BoxIntersection<T, Dim>::Status BoxIntersection<T, Dim>::Sweep(size_t slab, Sink& sink, size_t& numPairs) const
+	{
+		RecordReader<RecordType> reader(TempPath("slab", slab).string(), m_Params.RecordsInBuffer);
+
+		if (!reader.IsOpen())
+			return Status::ReadFailed;
+
+		const ValType lower = m_SlabBounds[slab];
+		const ValType upper = slab + 1 < m_SlabBounds.size() ? m_SlabBounds[slab + 1] : std::numeric_limits<ValType>::infinity();
+
+		// Boxes crossing the sweep line
+		std::vector<RecordType> active;
+
+		while (const RecordType* record = reader.Next())
+		{
+			const RecordType b = *record;
+
+			// Pairs whose overlap starts before the slab were reported by a previous slab
+			const bool report = lower <= b.Min[0] && b.Min[0] < upper;
+
+			for (size_t k = 0; k < active.size();)
+			{
+				const RecordType& a = active[k];
+
+				if (a.Max[0] < b.Min[0])
+				{
+					active[k] = active.back();
+					active.pop_back();
+
+					continue;
+				}
+
+				++k;
+
+				if (!report)
+					continue;
+
+				bool overlap = true;
+
+				for (size_t i = 1; i < Dim; ++i)
+					overlap &= (a.Min[i] <= b.Max[i]) & (b.Min[i] <= a.Max[i]);
+
+				if (!overlap)
+					continue;
+
+				if (auto result = ComputeCollision(a.Box(), b.Box()))
+				{
+					sink(slab, a.Id, b.Id, *result);
+					++numPairs;
+				}
+			}
+
+			active.push_back(b);
+		}
+
+		return reader.Good() ? Status::Success : Status::ReadFailed;
+	}
+
+	////////////////////////
+	//-- Shortcut types --//
+	////////////////////////
+
+	using BoxIntersection2Df = BoxIntersection<float, 2>;
+	using BoxIntersection3Df = BoxIntersection<float, 3>;
+}
@@ -0,0 +1,360 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+#include "LCN_Collisions/Source/Shapes/Hyperplane.h"
+#include "LCN_Collisions/Source/Shapes/PointCloud.h"
+#include "LCN_Collisions/Source/Concurrency/ParallelFor.h"
+#include "LCN_Collisions/Source/Core/Bits.h"
+#include "LCN_Collisions/Source/Memory/Allocator.h"
+
+namespace LCN
+{
+	//////////////////////////////////////////////
+	//-- Point cloud vs hyperplane, batch API --//
+	//////////////////////////////////////////////
+
+	// A point is in front of a hyperplane when its signed distance is strictly positive,
+	// behind otherwise. Distances are measured in units of the hyperplane normal.
+	// Every function streams the coordinate arrays once per pass and splits the
+	// points across threads in chunks of whole 64 points blocks.
+
+	enum class PartitionPolicy
+	{
+		Stable,
+		Unstable
+	};
+
+	enum : size_t
+	{
+		HalfSpaceBlockSize = 64,
+		HalfSpaceGrain     = 64 * HalfSpaceBlockSize
+	};
+
+	// Normal and offset of the equation n.x - offset = 0
+	template<typename T, size_t Dim>
+	struct HalfSpaceEquation
+	{
+		explicit HalfSpaceEquation(const Hyperplane<T, Dim>& hplane)
+		{
+			Offset = T(0);
+
+			for (size_t i = 0; i < Dim; ++i)
+			{
+				Normal[i] = hplane.Normal()[i];
+				Offset   += Normal[i] * hplane.Origin()[i];
+			}
+		}
+
+		// Signed distances of the points [begin, end) of the cloud
+		template<class CloudType>
+		void Distances(const CloudType& cloud, size_t begin, size_t end, T* out) const
+		{
+			const size_t count = end - begin;
+
+			for (size_t j = 0; j < count; ++j)
+				out[j] = -Offset;
+
+			for (size_t i = 0; i < Dim; ++i)
+			{
+				const T* coords = cloud.Coords(i) + begin;
+				const T  n      = Normal[i];
+
+				for (size_t j = 0; j < count; ++j)
+					out[j] += n * coords[j];
+			}
+		}
+
+		// Bit j set when the point begin + j is in front, count <= 64
+		template<class CloudType>
+		uint64_t Mask(const CloudType& cloud, size_t begin, size_t count) const
+		{
+			T distances[HalfSpaceBlockSize];
+
+			Distances(cloud, begin, begin + count, distances);
+
+			uint64_t mask = 0;
+
+			for (size_t j = 0; j < count; ++j)
+				mask |= uint64_t(distances[j] > T(0)) << j;
+
+			return mask;
+		}
+
+		T Normal[Dim];
+		T Offset;
+	};
+
+	////////////////////////
+	//-- Classification --//
+	////////////////////////
+
+	// Signed distance of every point to the hyperplane, out must hold cloud.Size() values
+	template<typename T, size_t Dim, class Allocator>
+	inline void
+	SignedDistances(
+		const PointCloud<T, Dim, Allocator>& cloud,
+		const Hyperplane<T, Dim>& hplane,
+		T* out)
+	{
+		const HalfSpaceEquation<T, Dim> equation(hplane);
+
+		ParallelFor(cloud.Size(), HalfSpaceGrain, [&](size_t, size_t begin, size_t end)
+		{
+			for (size_t b = begin; b < end; b += HalfSpaceBlockSize)
+				equation.Distances(cloud, b, std::min(b + HalfSpaceBlockSize, end), out + b);
+		});
+	}
+
+	// Bit (j % 64) of mask[j / 64] is set when point j is in front of the hyperplane.
+	// Returns the number of points in front.
+	template<typename T, size_t Dim, class Allocator, class MaskAllocator>
+	inline size_t
+	ClassifyPoints(
+		const PointCloud<T, Dim, Allocator>& cloud,
+		const Hyperplane<T, Dim>& hplane,
+		std::vector<uint64_t, MaskAllocator>& mask)
+	{
+		const HalfSpaceEquation<T, Dim> equation(hplane);
+
+		const ParallelRange range = SplitRange(cloud.Size(), HalfSpaceGrain);
+
+		mask.resize((cloud.Size() + HalfSpaceBlockSize - 1) / HalfSpaceBlockSize);
+
+		AllocVector<size_t, Allocator> inFront(range.NumChunks, 0, cloud.GetAllocator());
+
+		ParallelFor(range, [&](size_t chunk, size_t begin, size_t end)
+		{
+			for (size_t b = begin; b < end; b += HalfSpaceBlockSize)
+			{
+				uint64_t word = equation.Mask(cloud, b, std::min<size_t>(HalfSpaceBlockSize, end - b));
+
+				mask[b / HalfSpaceBlockSize] = word;
+				inFront[chunk] += PopCount(word);
+			}
+		});
+
+		size_t total = 0;
+
+		for (size_t count : inFront)
+			total += count;
+
+		return total;
+	}
+
+	// Bit p of codes[j] is set when point j is in front of hplanes[p], with at most one hyperplane
+	// per bit of CodeType (uint32_t or uint64_t codes, for up to 32 or 64 hyperplanes). Throws
+	// std::length_error when there are more hyperplanes.
+	// A point is inside the convex region bounded by the hyperplanes when its code is 0.
+	template<typename T, size_t Dim, class Allocator, typename CodeType, class CodeAllocator>
+	inline void
+	ClassifyPoints(
+		const PointCloud<T, Dim, Allocator>& cloud,
+		const std::vector<Hyperplane<T, Dim>>& hplanes,
+		std::vector<CodeType, CodeAllocator>& codes)
+	{
+		static_assert(std::is_integral_v<CodeType> && std::is_unsigned_v<CodeType>, "Codes must be unsigned integers");
+
+		if (hplanes.size() > 8 * sizeof(CodeType))
+			throw std::length_error("ClassifyPoints : more hyperplanes than bits in a code");
+
+		AllocVector<HalfSpaceEquation<T, Dim>, Allocator> equations(cloud.GetAllocator());
+		equations.reserve(hplanes.size());
+
+		for (const auto& hplane : hplanes)
+			equations.emplace_back(hplane);
+
+		codes.resize(cloud.Size());
+
+		ParallelFor(cloud.Size(), HalfSpaceGrain, [&](size_t, size_t begin, size_t end)
+		{
+			T distances[HalfSpaceBlockSize];
+
+			// Block outer loop, the codes of a block stay in L1 across hyperplanes
+			for (size_t b = begin; b < end; b += HalfSpaceBlockSize)
+			{
+				const size_t count = std::min<size_t>(HalfSpaceBlockSize, end - b);
+
+				CodeType* blockCodes = codes.data() + b;
+
+				for (size_t j = 0; j < count; ++j)
+					blockCodes[j] = 0;
+
+				for (size_t p = 0; p < equations.size(); ++p)
+				{
+					equations[p].Distances(cloud, b, b + count, distances);
+
+					for (size_t j = 0; j < count; ++j)
+						blockCodes[j] |= CodeType(distances[j] > T(0)) << p;
+				}
+			}
+		});
+	}
+
+	//////////////////////
+	//-- Partitioning --//
+	//////////////////////
+
+	// Moves the points behind the hyperplane before the points in front of it.
+	// Returns the number of points behind.
+	// Unstable : in place, each thread partitions its chunk then misplaced points are swapped in parallel.
+	// Stable   : keeps the relative order on both sides, uses one scratch array per pass.
+	// Scratch memory comes from the allocator of the cloud.
+	template<typename T, size_t Dim, class Allocator>
+	inline size_t
+	PartitionPoints(
+		PointCloud<T, Dim, Allocator>& cloud,
+		const Hyperplane<T, Dim>& hplane,
+		PartitionPolicy policy = PartitionPolicy::Unstable)
+	{
+		const size_t size = cloud.Size();
+
+		const Allocator& alloc = cloud.GetAllocator();
+
+		AllocVector<uint64_t, Allocator> mask(alloc);
+
+		const size_t inFront = ClassifyPoints(cloud, hplane, mask);
+		const size_t behind  = size - inFront;
+
+		auto isInFront = [&](size_t j) { return (mask[j / HalfSpaceBlockSize] >> (j % HalfSpaceBlockSize)) & 1; };
+
+		const ParallelRange range = SplitRange(size, HalfSpaceGrain);
+
+		// Number of points behind the hyperplane in each chunk
+		AllocVector<size_t, Allocator> chunkBehind(range.NumChunks, 0, alloc);
+
+		for (size_t c = 0; c < range.NumChunks; ++c)
+		{
+			size_t count = 0;
+
+			for (size_t w = range.Begin(c) / HalfSpaceBlockSize; w < (range.End(c) + HalfSpaceBlockSize - 1) / HalfSpaceBlockSize; ++w)
+				count += PopCount(mask[w]);
+
+			chunkBehind[c] = (range.End(c) - range.Begin(c)) - count;
+		}
+
+		if (policy == PartitionPolicy::Stable)
+		{
+			AllocVector<size_t, Allocator> behindOffset(range.NumChunks, 0, alloc);
+			AllocVector<size_t, Allocator> frontOffset(range.NumChunks, 0, alloc);
+
+			for (size_t c = 0, b = 0, f = behind; c < range.NumChunks; ++c)
+			{
+				behindOffset[c] = b;
+				frontOffset[c]  = f;
+
+				b += chunkBehind[c];
+				f += (range.End(c) - range.Begin(c)) - chunkBehind[c];
+			}
+
+			auto scatter = [&](auto* values, auto& scratch)
+			{
+				ParallelFor(range, [&](size_t chunk, size_t begin, size_t end)
+				{
+					size_t b = behindOffset[chunk];
+					size_t f = frontOffset[chunk];
+
+					for (size_t j = begin; j < end; ++j)
+						scratch[isInFront(j) ? f++ : b++] = values[j];
+				});
+
+				ParallelFor(range, [&](size_t, size_t begin, size_t end)
+				{
+					std::copy(scratch.begin() + begin, scratch.begin() + end, values + begin);
+				});
+			};
+
+			{
+				AllocVector<T, Allocator> coordScratch(size, T(0), alloc);
+
+				for (size_t i = 0; i < Dim; ++i)
+					scatter(cloud.Coords(i), coordScratch);
+			}
+
+			AllocVector<uint32_t, Allocator> idScratch(size, 0, alloc);
+
+			scatter(cloud.Ids(), idScratch);
+
+			return behind;
+		}
+
+		// Local partitions. A position is never read after it has been written, so the
+		// mask computed before any swap stays valid.
+		ParallelFor(range, [&](size_t, size_t begin, size_t end)
+		{
+			size_t lo = begin;
+			size_t hi = end;
+
+			for (;;)
+			{
+				while (lo < hi && !isInFront(lo))
+					++lo;
+
+				while (lo < hi && isInFront(hi - 1))
+					--hi;
+
+				if (lo >= hi)
+					break;
+
+				cloud.Swap(lo++, --hi);
+			}
+		});
+
+		// Points in front left of the split and points behind right of it, as lists of intervals
+		struct Interval
+		{
+			size_t Begin;
+			size_t End;
+		};
+
+		AllocVector<Interval, Allocator> wrongFront(alloc), wrongBehind(alloc);
+
+		for (size_t c = 0; c < range.NumChunks; ++c)
+		{
+			const size_t split = range.Begin(c) + chunkBehind[c];
+
+			if (split < behind)
+				wrongFront.push_back(Interval{ split, std::min(range.End(c), behind) });
+
+			if (split > behind)
+				wrongBehind.push_back(Interval{ std::max(range.Begin(c), behind), split });
+		}
+
+		auto prefix = [&](const AllocVector<Interval, Allocator>& intervals)
+		{
+			AllocVector<size_t, Allocator> result(intervals.size() + 1, 0, alloc);
+
+			for (size_t k = 0; k < intervals.size(); ++k)
+				result[k + 1] = result[k] + (intervals[k].End - intervals[k].Begin);
+
+			return result;
+		};
+
+		const auto frontPrefix  = prefix(wrongFront);
+		const auto behindPrefix = prefix(wrongBehind);
+
+		ParallelFor(frontPrefix.back(), HalfSpaceGrain, [&](size_t, size_t begin, size_t end)
+		{
+			// Interval holding the begin-th misplaced point of each list
+			size_t f = size_t(std::upper_bound(frontPrefix.begin(),  frontPrefix.end(),  begin) - frontPrefix.begin())  - 1;
+			size_t b = size_t(std::upper_bound(behindPrefix.begin(), behindPrefix.end(), begin) - behindPrefix.begin()) - 1;
+
+			for (size_t k = begin; k < end; ++k)
+			{
+				while (k >= frontPrefix[f + 1])
+					++f;
+
+				while (k >= behindPrefix[b + 1])
+					++b;
+
+				cloud.Swap(wrongFront[f].Begin + (k - frontPrefix[f]), wrongBehind[b].Begin + (k - behindPrefix[b]));
+			}
+		});
+
+		return behind;
+	}
+}
@@ -0,0 +1,418 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+#include <Utilities/Source/ErrorHandling.h>
+
+#include "LCN_Collisions/Source/Shapes/AABB.h"
+#include "LCN_Collisions/Source/Shapes/PointCloud.h"
+#include "LCN_Collisions/Source/Concurrency/ParallelFor.h"
+#include "LCN_Collisions/Source/Core/Bits.h"
+#include "LCN_Collisions/Source/Memory/Allocator.h"
+
+namespace LCN
+{
+	///////////////////////
+	//-- Region lookup --//
+	///////////////////////
+
+	// Maps batches of 2D points to the regions (AABB<T, 2>) containing them.
+	// Regions are bucketed in a uniform grid over their bounds, a region being copied
+	// in every cell it overlaps. Regions overlapping more than MaxCellsPerRegion cells
+	// are not copied but kept in one list of large regions tested for every point, so
+	// a few huge regions among small ones do not blow up the cells.
+	// The regions of a cell, like the large ones, are stored as structure of arrays in
+	// increasing id order and padded to LaneWidth with empty boxes, so a point is tested
+	// against LaneWidth regions at once with branch-free comparisons.
+	// Like DetectCollision(AABB, Point), the faces belong to the regions.
+	template<typename T, class Allocator = std::allocator<T>>
+	class RegionLookup
+	{
+	public:
+		using ValType       = T;
+		using AABBType      = AABB<ValType, 2>;
+		using AllocatorType = Allocator;
+
+		static constexpr size_t   LaneWidth = 32 / sizeof(ValType);
+		static constexpr uint32_t NoRegion  = std::numeric_limits<uint32_t>::max();
+
+		enum : size_t
+		{
+			Grain             = 4096,
+			MaxCellsPerRegion = 64
+		};
+
+		explicit RegionLookup(const Allocator& alloc = Allocator());
+
+		// regionsPerCell sets the resolution of the grid : about numRegions / regionsPerCell cells
+		void Build(const AABBType* regions, size_t numRegions, ValType regionsPerCell = ValType(4));
+
+		void Build(const std::vector<AABBType>& regions, ValType regionsPerCell = ValType(4))
+		{
+			Build(regions.data(), regions.size(), regionsPerCell);
+		}
+
+		// out[i] is the smallest id of the regions containing point i, or NoRegion
+		void LookupFirst(const ValType* xs, const ValType* ys, size_t count, uint32_t* out) const;
+
+		// Ids of the regions containing point i are ids[offsets[i]] to ids[offsets[i + 1] - 1], in increasing order.
+		// OffsetType is any unsigned integer, uint64_t when the total number of ids may not fit in 32 bits.
+		// Throws std::length_error when it does not fit in OffsetType.
+		template<typename OffsetType, class OffsetAllocator, class IdAllocator>
+		void LookupAll(const ValType* xs, const ValType* ys, size_t count, std::vector<OffsetType, OffsetAllocator>& offsets, std::vector<uint32_t, IdAllocator>& ids) const;
+
+		template<class CloudAllocator, class OutAllocator>
+		void LookupFirst(const PointCloud<ValType, 2, CloudAllocator>& cloud, std::vector<uint32_t, OutAllocator>& out) const
+		{
+			out.resize(cloud.Size());
+
+			LookupFirst(cloud.Coords(0), cloud.Coords(1), cloud.Size(), out.data());
+		}
+
+		template<class CloudAllocator, typename OffsetType, class OffsetAllocator, class IdAllocator>
+		void LookupAll(const PointCloud<ValType, 2, CloudAllocator>& cloud, std::vector<OffsetType, OffsetAllocator>& offsets, std::vector<uint32_t, IdAllocator>& ids) const
+		{
+			LookupAll(cloud.Coords(0), cloud.Coords(1), cloud.Size(), offsets, ids);
+		}
+
+		size_t NumRegions() const { return m_NumRegions; }
+		size_t NumCells()   const { return m_CellsX * m_CellsY; }
+		size_t NumLarge()   const { return m_NumLarge; }
+
+	private:
+		// Cell holding (x, y), false when the point is outside of the grid
+		bool CellOf(ValType x, ValType y, size_t& cell) const;
+
+		// Calls func(id) for every region containing (x, y), in increasing id order, until func returns false
+		template<class Func>
+		void ForEachRegion(ValType x, ValType y, Func&& func) const;
+
+		size_t CellIndex(ValType coord, size_t axis) const;
+
+		// Bit j set when the region at b + j contains (x, y)
+		uint32_t BlockMask(size_t b, ValType x, ValType y) const;
+
+		Allocator m_Allocator;
+
+		ValType m_Min[2];
+		ValType m_Max[2];
+		ValType m_InvCellSize[2];
+
+		size_t m_CellsX     = 0;
+		size_t m_CellsY     = 0;
+		size_t m_NumRegions = 0;
+		size_t m_NumLarge   = 0;
+
+		// Start of the regions of each cell, a multiple of LaneWidth.
+		// The large regions follow the last cell, up to the end of the arrays.
+		AllocVector<size_t, Allocator> m_CellOffsets;
+
+		AllocVector<ValType, Allocator>  m_MinX;
+		AllocVector<ValType, Allocator>  m_MinY;
+		AllocVector<ValType, Allocator>  m_MaxX;
+		AllocVector<ValType, Allocator>  m_MaxY;
+		AllocVector<uint32_t, Allocator> m_Ids;
+	};
+
+	////////////////////////
+	//-- Implementation --//
+	////////////////////////
+
+	template<typename T, class Allocator>
+	inline RegionLookup<T, Allocator>::RegionLookup(const Allocator& alloc) :
+		m_Allocator(alloc),
+		m_Min{ ValType(0), ValType(0) },
+		m_Max{ ValType(0), ValType(0) },
+		m_InvCellSize{ ValType(0), ValType(0) },
+		m_CellOffsets(1, 0, alloc),
+		m_MinX(alloc),
+		m_MinY(alloc),
+		m_MaxX(alloc),
+		m_MaxY(alloc),
+		m_Ids(alloc)
+	{}
+
+	template<typename T, class Allocator>
+	inline size_t RegionLookup<T, Allocator>::CellIndex(ValType coord, size_t axis) const
+	{
+		const size_t numCells = axis == 0 ? m_CellsX : m_CellsY;
+
+		ValType cell = (coord - m_Min[axis]) * m_InvCellSize[axis];
+
+		return std::min(size_t(std::max(cell, ValType(0))), numCells - 1);
+	}
+
+	template<typename T, class Allocator>
+	inline void RegionLookup<T, Allocator>::Build(const AABBType* regions, size_t numRegions, ValType regionsPerCell)
+	{
+		ASSERT(numRegions < NoRegion);
+
+		m_NumRegions = numRegions;
+
+		for (size_t i = 0; i < 2; ++i)
+		{
+			m_Min[i] =  std::numeric_limits<ValType>::infinity();
+			m_Max[i] = -std::numeric_limits<ValType>::infinity();
+		}
+
+		for (size_t r = 0; r < numRegions; ++r)
+		{
+			for (size_t i = 0; i < 2; ++i)
+			{
+				m_Min[i] = std::min(m_Min[i], regions[r].Min()[i]);
+				m_Max[i] = std::max(m_Max[i], regions[r].Max()[i]);
+			}
+		}
+
+		// Cells about as square as the bounds allow
+		const ValType width  = numRegions ? m_Max[0] - m_Min[0] : ValType(0);
+		const ValType height = numRegions ? m_Max[1] - m_Min[1] : ValType(0);
+		const ValType cells  = std::max(ValType(1), ValType(numRegions) / std::max(regionsPerCell, ValType(1)));
+
+		auto numCells = [](ValType count) { return size_t(std::clamp(std::round(count), ValType(1), ValType(1 << 14))); };
+
+		if (width > ValType(0) && height > ValType(0))
+		{
+			m_CellsX = numCells(std::sqrt(cells * width / height));
+			m_CellsY = numCells(cells / ValType(m_CellsX));
+		}
+		else
+		{
+			m_CellsX = width  > ValType(0) ? numCells(cells) : 1;
+			m_CellsY = height > ValType(0) ? numCells(cells) : 1;
+		}
+
+		m_InvCellSize[0] = width  > ValType(0) ? ValType(m_CellsX) / width  : ValType(0);
+		m_InvCellSize[1] = height > ValType(0) ? ValType(m_CellsY) / height : ValType(0);
+
+		// Calls func(cell) for every cell of the region, or func(NumCells()) once for a large region
+		auto forEachCell = [&](const AABBType& region, auto&& func)
+		{
+			const size_t x0 = CellIndex(region.Min()[0], 0), x1 = CellIndex(region.Max()[0], 0);
+			const size_t y0 = CellIndex(region.Min()[1], 1), y1 = CellIndex(region.Max()[1], 1);
+
+			if ((x1 - x0 + 1) * (y1 - y0 + 1) > MaxCellsPerRegion)
+			{
+				func(NumCells());
+				return;
+			}
+
+			for (size_t y = y0; y <= y1; ++y)
+				for (size_t x = x0; x <= x1; ++x)
+					func(y * m_CellsX + x);
+		};
+
+		// Regions per cell and large regions, then padded offsets
+		AllocVector<size_t, Allocator> counts(NumCells() + 1, 0, m_Allocator);
+
+		for (size_t r = 0; r < numRegions; ++r)
+			forEachCell(regions[r], [&](size_t cell) { ++counts[cell]; });
+
+		m_NumLarge = counts[NumCells()];
+
+		auto padded = [](size_t count) { return (count + LaneWidth - 1) / LaneWidth * LaneWidth; };
+
+		m_CellOffsets.resize(NumCells() + 1);
+		m_CellOffsets[0] = 0;
+
+		for (size_t cell = 0; cell < NumCells(); ++cell)
+			m_CellOffsets[cell + 1] = m_CellOffsets[cell] + padded(counts[cell]);
+
+		// Empty boxes in the padding never contain a point
+		const size_t size = m_CellOffsets.back() + padded(m_NumLarge);
+
+		m_MinX.assign(size,  std::numeric_limits<ValType>::infinity());
+		m_MinY.assign(size,  std::numeric_limits<ValType>::infinity());
+		m_MaxX.assign(size, -std::numeric_limits<ValType>::infinity());
+		m_MaxY.assign(size, -std::numeric_limits<ValType>::infinity());
+		m_Ids.assign(size, NoRegion);
+
+		// Regions are visited in id order, so every cell ends up sorted
+		std::copy(m_CellOffsets.begin(), m_CellOffsets.end(), counts.begin());
+
+		for (size_t r = 0; r < numRegions; ++r)
+		{
+			forEachCell(regions[r], [&](size_t cell)
+			{
+				const size_t e = counts[cell]++;
+
+				m_MinX[e] = regions[r].Min()[0];
+				m_MinY[e] = regions[r].Min()[1];
+				m_MaxX[e] = regions[r].Max()[0];
+				m_MaxY[e] = regions[r].Max()[1];
+				m_Ids[e]  = uint32_t(r);
+			});
+		}
+	}
+
+	template<typename T, class Allocator>
+	inline bool RegionLookup<T, Allocator>::CellOf(ValType x, ValType y, size_t& cell) const
+	{
+		// Also rejects NaN coordinates
+		if (!(m_Min[0] <= x && x <= m_Max[0] && m_Min[1] <= y && y <= m_Max[1]))
+			return false;
+
+		cell = CellIndex(y, 1) * m_CellsX + CellIndex(x, 0);
+
+		return true;
+	}
+
+	template<typename T, class Allocator>
+	template<class Func>
+	inline void RegionLookup<T, Allocator>::ForEachRegion(ValType x, ValType y, Func&& func) const
+	{
+		size_t cell;
+
+		if (!CellOf(x, y, cell))
+			return;
+
+		// Next region of [b, end) containing the point, mask holding the hits of the block before b
+		auto next = [&](size_t& b, size_t end, uint32_t& mask)
+		{
+			while (mask == 0)
+			{
+				if (b >= end)
+					return NoRegion;
+
+				mask = BlockMask(b, x, y);
+				b   += LaneWidth;
+			}
+
+			const uint32_t j = CountTrailingZeros(mask);
+			mask &= mask - 1;
+
+			return m_Ids[b - LaneWidth + j];
+		};
+
+		// Merges the regions of the cell and the large regions, both sorted by id
+		size_t   cellBlock  = m_CellOffsets[cell], largeBlock = m_CellOffsets.back();
+		uint32_t cellMask   = 0,                   largeMask  = 0;
+
+		uint32_t cellId  = next(cellBlock,  m_CellOffsets[cell + 1], cellMask);
+		uint32_t largeId = next(largeBlock, m_Ids.size(),            largeMask);
+
+		while (cellId != NoRegion || largeId != NoRegion)
+		{
+			if (cellId < largeId)
+			{
+				if (!func(cellId))
+					return;
+
+				cellId = next(cellBlock, m_CellOffsets[cell + 1], cellMask);
+			}
+			else
+			{
+				if (!func(largeId))
+					return;
+
+				largeId = next(largeBlock, m_Ids.size(), largeMask);
+			}
+		}
+	}
+
+	template<typename T, class Allocator>
+	inline uint32_t RegionLookup<T, Allocator>::BlockMask(size_t b, ValType x, ValType y) const
+	{
+		const ValType* minX = m_MinX.data() + b;
+		const ValType* minY = m_MinY.data() + b;
+		const ValType* maxX = m_MaxX.data() + b;
+		const ValType* maxY = m_MaxY.data() + b;
+
+		uint32_t mask = 0;
+
+		for (size_t j = 0; j < LaneWidth; ++j)
+		{
+			const bool inside =
+				(minX[j] <= x) & (x <= maxX[j]) &
+				(minY[j] <= y) & (y <= maxY[j]);
+
+			mask |= uint32_t(inside) << j;
+		}
+
+		return mask;
+	}
+
+	template<typename T, class Allocator>
+	inline void RegionLookup<T, Allocator>::LookupFirst(const ValType* xs, const ValType* ys, size_t count, uint32_t* out) const
+	{
+		ParallelFor(count, Grain, [&](size_t, size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				uint32_t first = NoRegion;
+
+				ForEachRegion(xs[i], ys[i], [&](uint32_t id)
+				{
+					first = id;
+					return false;
+				});
+
+				out[i] = first;
+			}
+		});
+	}
+
+	template<typename T, class Allocator>
+	template<typename OffsetType, class OffsetAllocator, class IdAllocator>
+	inline void RegionLookup<T, Allocator>::LookupAll(const ValType* xs, const ValType* ys, size_t count, std::vector<OffsetType, OffsetAllocator>& offsets, std::vector<uint32_t, IdAllocator>& ids) const
+	{
+		static_assert(std::is_integral_v<OffsetType> && std::is_unsigned_v<OffsetType>, "Offsets must be unsigned integers");
+
+		const ParallelRange range = SplitRange(count, Grain);
+
+		// Each chunk collects its ids on its own, then they are copied side by side
+		std::vector<AllocVector<uint32_t, IdAllocator>> chunkIds(range.NumChunks, AllocVector<uint32_t, IdAllocator>(ids.get_allocator()));
+
+		offsets.resize(count + 1);
+		offsets[0] = 0;
+
+		ParallelFor(range, [&](size_t chunk, size_t begin, size_t end)
+		{
+			auto& local = chunkIds[chunk];
+
+			for (size_t i = begin; i < end; ++i)
+			{
+				ForEachRegion(xs[i], ys[i], [&](uint32_t id)
+				{
+					local.push_back(id);
+					return true;
+				});
+
+				offsets[i + 1] = OffsetType(local.size());
+			}
+		});
+
+		AllocVector<size_t, OffsetAllocator> chunkOffsets(range.NumChunks + 1, 0, offsets.get_allocator());
+
+		for (size_t c = 0; c < range.NumChunks; ++c)
+			chunkOffsets[c + 1] = chunkOffsets[c] + chunkIds[c].size();
+
+		// The offsets of a chunk only wrap if the total does too
+		if (chunkOffsets.back() > std::numeric_limits<OffsetType>::max())
+			throw std::length_error("RegionLookup::LookupAll : too many ids for the offset type");
+
+		ids.resize(chunkOffsets.back());
+
+		ParallelFor(range, [&](size_t chunk, size_t begin, size_t end)
+		{
+			const OffsetType base = OffsetType(chunkOffsets[chunk]);
+
+			for (size_t i = begin; i < end; ++i)
+				offsets[i + 1] += base;
+
+			std::copy(chunkIds[chunk].begin(), chunkIds[chunk].end(), ids.begin() + base);
+		});
+	}
+
+	////////////////////////
+	//-- Shortcut types --//
+	////////////////////////
+
+	using RegionLookup2Df = RegionLookup<float>;
+}
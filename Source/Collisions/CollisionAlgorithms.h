@@ -2,6 +2,7 @@
 
 #include <optional>
 #include <cmath>
+#include <algorithm>
 
 #include "LCN_Collisions/Source/Shapes/Point.h"
 #include "LCN_Collisions/Source/Shapes/Line.h"
@@ -9,6 +10,7 @@
 #include "LCN_Collisions/Source/Shapes/Plane.h"
 #include "LCN_Collisions/Source/Shapes/Hyperplane.h"
 #include "LCN_Collisions/Source/Shapes/Sphere.h"
+#include "LCN_Collisions/Source/Shapes/Triangle.h"
 
 #include "LCN_Collisions/Source/Collisions/CollisionResult.h"
 
@@ -32,18 +34,20 @@ namespace LCN
 		return DetectCollision(shape2, shape1);
 	}
 
-	// AABB vs point
-	template<typename T>
+	// AABB vs point, the faces belong to the AABB
+	template<typename T, size_t Dim>
 	inline bool
 	DetectCollision(
-		const AABB<T, 2>& aabb,
-		const Point<T, 2>& point)
+		const AABB<T, Dim>& aabb,
+		const Point<T, Dim>& point)
 	{
-		const Point<T, 2>& topLeft = aabb.TopLeft();
+		bool inside = true;
+
+		// No early out, the Dim comparisons compile to a few branch-free instructions
+		for (size_t i = 0; i < Dim; ++i)
+			inside &= (aabb.Min()[i] <= point[i]) & (point[i] <= aabb.Max()[i]);
 
-		return
-			(point.x() >= topLeft.x() && point.x() <= (topLeft.x() + aabb.Width())) &&
-			(point.y() <= topLeft.y() && point.y() >= (topLeft.y() - aabb.Height()));
+		return inside;
 	}
 
 	// AABB vs AABB
@@ -67,6 +71,26 @@ namespace LCN
 		return true;
 	}
 
+	// AABB vs Sphere
+	template<typename T, size_t Dim>
+	inline bool
+	DetectCollision(
+		const AABB<T, Dim>& aabb,
+		const SphereND<T, Dim>& sphere)
+	{
+		T squareDistance = 0;
+
+		for (size_t i = 0; i < Dim; ++i)
+		{
+			T c = sphere.Center()[i];
+			T d = c - std::clamp(c, aabb.Min()[i], aabb.Max()[i]);
+
+			squareDistance += d * d;
+		}
+
+		return squareDistance <= sphere.SquareRadius();
+	}
+
 	// Hyperplane vs Line
 	template<typename T, size_t Dim>
 	inline bool
@@ -115,6 +139,69 @@ namespace LCN
 		return squareDistance <= sphere.SquareRadius();
 	}
 
+	// AABB vs Triangle (separating axis theorem)
+	template<typename T>
+	inline bool
+	DetectCollision(
+		const AABB<T, 3>& aabb,
+		const Triangle<T>& triangle)
+	{
+		T half[3], v[3][3];
+
+		for (size_t i = 0; i < 3; ++i)
+		{
+			T center = (aabb.Min()[i] + aabb.Max()[i]) / 2;
+
+			half[i] = (aabb.Max()[i] - aabb.Min()[i]) / 2;
+
+			for (size_t k = 0; k < 3; ++k)
+				v[k][i] = triangle[k][i] - center;
+		}
+
+		// Projects the triangle on an axis and checks it against the box projection
+		auto separated = [&](T ax, T ay, T az)
+		{
+			T p0 = ax * v[0][0] + ay * v[0][1] + az * v[0][2];
+			T p1 = ax * v[1][0] + ay * v[1][1] + az * v[1][2];
+			T p2 = ax * v[2][0] + ay * v[2][1] + az * v[2][2];
+
+			T r = half[0] * std::abs(ax) + half[1] * std::abs(ay) + half[2] * std::abs(az);
+
+			return std::min({ p0, p1, p2 }) > r || std::max({ p0, p1, p2 }) < -r;
+		};
+
+		// Box face normals
+		if (separated(1, 0, 0) || separated(0, 1, 0) || separated(0, 0, 1))
+			return false;
+
+		T e[3][3];
+
+		for (size_t i = 0; i < 3; ++i)
+		{
+			e[0][i] = v[1][i] - v[0][i];
+			e[1][i] = v[2][i] - v[1][i];
+			e[2][i] = v[0][i] - v[2][i];
+		}
+
+		// Triangle normal
+		if (separated(
+			e[0][1] * e[1][2] - e[0][2] * e[1][1],
+			e[0][2] * e[1][0] - e[0][0] * e[1][2],
+			e[0][0] * e[1][1] - e[0][1] * e[1][0]))
+			return false;
+
+		// Box axes x triangle edges
+		for (size_t k = 0; k < 3; ++k)
+		{
+			if (separated(0, -e[k][2], e[k][1]) ||
+				separated(e[k][2], 0, -e[k][0]) ||
+				separated(-e[k][1], e[k][0], 0))
+				return false;
+		}
+
+		return true;
+	}
+
 #pragma endregion
 
 #pragma region Computation
@@ -178,13 +265,17 @@ namespace LCN
 		T r_2    = sphere.SquareRadius();
 		T vDotCO = (v | co);
 		T dCO_2  = co.SquareNorm();
-		T delta  = 4 * (vDotCO * vDotCO - dCO_2 + r_2);
+
+		// Quarter of the discriminant, the direction being normalized
+		T delta = vDotCO * vDotCO - dCO_2 + r_2;
 
 		if (delta < 0)
 			return ResultType{ std::nullopt };
 
-		T t1 = (-2 * vDotCO - std::sqrt(delta)) / 2;
-		T t2 = (-2 * vDotCO + std::sqrt(delta)) / 2;
+		T sqrtDelta = std::sqrt(delta);
+
+		T t1 = -vDotCO - sqrtDelta;
+		T t2 = -vDotCO + sqrtDelta;
 
 		return ResultType{
 			std::in_place,
@@ -278,5 +369,33 @@ namespace LCN
 		return ResultType{ std::in_place, result };
 	}
 
+	// Triangle vs Line intersection (watertight)
+	template<typename T>
+	std::optional<TriangleVSLine<T>>
+	ComputeCollision(
+		const Triangle<T>& triangle,
+		const Line<T, 3>& line)
+	{
+		using ResultType = std::optional<TriangleVSLine<T>>;
+
+		const WatertightRay<T> ray(line);
+
+		T a[3], b[3], c[3];
+
+		for (size_t i = 0; i < 3; ++i)
+		{
+			a[i] = triangle[0][i];
+			b[i] = triangle[1][i];
+			c[i] = triangle[2][i];
+		}
+
+		T t, u, v;
+
+		if (!ray.Intersect(a, b, c, t, u, v))
+			return ResultType{ std::nullopt };
+
+		return ResultType{ std::in_place, t * line.Direction() + line.Origin(), t, u, v };
+	}
+
 #pragma endregion
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 
 #include "LCN_Collisions/Source/Shapes/Plane.h"
 #include "LCN_Collisions/Source/Shapes/Line.h"
+#include "LCN_Collisions/Source/Shapes/Triangle.h"
 
 namespace LCN
 {
@@ -229,6 +230,53 @@ namespace LCN
 	template<typename T, size_t Dim>
 	using AABBVSLine = CollisionResult<AABB<T, Dim>, Line<T, Dim>>;
 
+#pragma endregion
+
+#pragma region Triangle vs Line
+
+	////////////////////////////////////
+	//-- Triangle vs Line (3D only) --//
+	////////////////////////////////////
+
+	template<typename T>
+	class CollisionResult<Triangle<T>, Line<T, 3>>
+	{
+	public:
+		using ValType      = T;
+		using TriangleType = Triangle<ValType>;
+		using LineType     = Line<ValType, 3>;
+
+		static_assert(std::is_same_v<typename TriangleType::HVectorType, typename LineType::HVectorType>);
+
+		using HVectorType = typename TriangleType::HVectorType;
+
+		CollisionResult() = default;
+
+		CollisionResult(const HVectorType& inter, ValType coordinate, ValType u, ValType v) :
+			m_Intersection{ inter },
+			m_Coordinate{ coordinate },
+			m_U{ u },
+			m_V{ v }
+		{}
+
+		const HVectorType& Result() const { return m_Intersection; }
+
+		const ValType Coordinate() const { return m_Coordinate; }
+
+		// Barycentric weights of the 2nd and 3rd vertices
+		const ValType U() const { return m_U; }
+		const ValType V() const { return m_V; }
+
+	private:
+		HVectorType m_Intersection;
+		ValType     m_Coordinate;
+		ValType     m_U;
+		ValType     m_V;
+	};
+
+	template<typename T>
+	using TriangleVSLine = CollisionResult<Triangle<T>, Line<T, 3>>;
+
 #pragma endregion
 
 	///////////////////////////////
@@ -248,4 +296,6 @@ namespace LCN
 
 	using AABBVSLine2Df = AABBVSLine<float, 2>;
 	using AABBVSLine3Df = AABBVSLine<float, 3>;
+
+	using TriangleVSLine3Df = TriangleVSLine<float>;
 }
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <type_traits>
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+
+namespace LCN
+{
+	////////////////////////
+	//-- Parallel range --//
+	////////////////////////
+
+	inline size_t HardwareThreads()
+	{
+		return std::max<size_t>(1, std::thread::hardware_concurrency());
+	}
+
+	// Split of [0, Count) in NumChunks contiguous chunks.
+	// Chunk boundaries are multiples of the grain, so that chunks never share a word
+	// of a bit mask or a cache line of an output array.
+	struct ParallelRange
+	{
+		size_t Count;
+		size_t ChunkSize;
+		size_t NumChunks;
+
+		size_t Begin(size_t chunk) const { return std::min(chunk * ChunkSize, Count); }
+		size_t End(size_t chunk)   const { return std::min((chunk + 1) * ChunkSize, Count); }
+	};
+
+	inline ParallelRange SplitRange(size_t count, size_t grain, size_t maxChunks = HardwareThreads())
+	{
+		grain     = std::max<size_t>(grain, 1);
+		maxChunks = std::max<size_t>(maxChunks, 1);
+
+		size_t chunkSize = (count + maxChunks - 1) / maxChunks;
+		chunkSize = std::max<size_t>((chunkSize + grain - 1) / grain * grain, grain);
+
+		return ParallelRange{ count, chunkSize, count == 0 ? 0 : (count + chunkSize - 1) / chunkSize };
+	}
+
+	/////////////////////
+	//-- Worker pool --//
+	/////////////////////
+
+	// Threads started once and shared by every ParallelFor of the process, so that a
+	// parallel loop neither creates threads nor allocates memory.
+	// A job lives on the stack of the thread that calls Run. That thread runs chunks of
+	// its own job and idle workers pick the most recent job, so nested parallel loops
+	// (a chunk calling ParallelFor) are fine and never wait for a free worker.
+	class WorkerPool
+	{
+	public:
+		explicit WorkerPool(size_t numWorkers);
+		~WorkerPool();
+
+		WorkerPool(const WorkerPool&) = delete;
+		WorkerPool& operator=(const WorkerPool&) = delete;
+
+		// HardwareThreads() - 1 workers, started by the first call
+		static WorkerPool& Instance()
+		{
+			static WorkerPool pool(HardwareThreads() - 1);
+
+			return pool;
+		}
+
+		size_t NumWorkers() const { return m_Workers.size(); }
+
+		// Calls func(chunk, begin, end) for every chunk of the range and returns once they are all done.
+		// The first exception thrown by a chunk is rethrown here, the chunks not started yet are skipped.
+		template<class Func>
+		void Run(const ParallelRange& range, Func& func);
+
+	private:
+		struct Job
+		{
+			void (*Call)(void* func, size_t chunk, size_t begin, size_t end);
+			void*                Func;
+			const ParallelRange* Range;
+			std::atomic<size_t>  NextChunk{ 0 };
+			size_t               Workers = 0; // Workers inside Execute, guarded by the mutex
+			std::exception_ptr   Error;
+			Job*                 Next = nullptr;
+		};
+
+		void Work();
+		void Execute(Job& job);
+		void Unlink(Job& job);
+
+		std::mutex              m_Mutex;
+		std::condition_variable m_WorkReady;
+		std::condition_variable m_JobDone;
+
+		Job* m_Jobs = nullptr; // Jobs that may still have chunks to run, most recent first
+		bool m_Stop = false;
+
+		std::vector<std::thread> m_Workers;
+	};
+
+	inline WorkerPool::WorkerPool(size_t numWorkers)
+	{
+		m_Workers.reserve(numWorkers);
+
+		for (size_t w = 0; w < numWorkers; ++w)
+			m_Workers.emplace_back([this]() { Work(); });
+	}
+
+	inline WorkerPool::~WorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Stop = true;
+		}
+
+		m_WorkReady.notify_all();
+
+		for (std::thread& worker : m_Workers)
+			worker.join();
+	}
+
+	template<class Func>
+	inline void WorkerPool::Run(const ParallelRange& range, Func& func)
+	{
+		using FuncType = std::remove_reference_t<Func>;
+
+		Job job;
+		job.Func  = const_cast<void*>(static_cast<const void*>(std::addressof(func)));
+		job.Range = &range;
+		job.Call  = [](void* f, size_t chunk, size_t begin, size_t end) { (*static_cast<FuncType*>(f))(chunk, begin, end); };
+
+		if (range.NumChunks > 1 && !m_Workers.empty())
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+
+				job.Next = m_Jobs;
+				m_Jobs   = &job;
+			}
+
+			m_WorkReady.notify_all();
+		}
+
+		Execute(job);
+
+		{
+			// Once unlinked no worker can join, wait for the ones still running a chunk
+			std::unique_lock<std::mutex> lock(m_Mutex);
+
+			Unlink(job);
+
+			m_JobDone.wait(lock, [&job]() { return job.Workers == 0; });
+		}
+
+		if (job.Error)
+			std::rethrow_exception(job.Error);
+	}
+
+	inline void WorkerPool::Work()
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		for (;;)
+		{
+			m_WorkReady.wait(lock, [this]() { return m_Stop || m_Jobs; });
+
+			if (m_Stop)
+				return;
+
+			Job& job = *m_Jobs;
+			++job.Workers;
+
+			lock.unlock();
+			Execute(job);
+			lock.lock();
+
+			// Every chunk is taken, the job is no longer worth picking
+			Unlink(job);
+
+			if (--job.Workers == 0)
+				m_JobDone.notify_all();
+		}
+	}
+
+	inline void WorkerPool::Execute(Job& job)
+	{
+		const ParallelRange& range = *job.Range;
+
+		for (size_t c = job.NextChunk++; c < range.NumChunks; c = job.NextChunk++)
+		{
+			try
+			{
+				job.Call(job.Func, c, range.Begin(c), range.End(c));
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+
+				if (!job.Error)
+					job.Error = std::current_exception();
+
+				// Skips the chunks not started yet
+				job.NextChunk = range.NumChunks;
+			}
+		}
+	}
+
+	inline void WorkerPool::Unlink(Job& job)
+	{
+		for (Job** link = &m_Jobs; *link; link = &(*link)->Next)
+		{
+			if (*link == &job)
+			{
+				*link = job.Next;
+				return;
+			}
+		}
+	}
+
+	//////////////////////
+	//-- Parallel for --//
+	//////////////////////
+
+	// Calls func(chunk, begin, end) for every chunk, on the calling thread and the
+	// workers of WorkerPool::Instance(). Chunks run in any order and must not wait for
+	// each other. The first exception thrown by a chunk is rethrown on the calling thread.
+	template<class Func>
+	inline void ParallelFor(const ParallelRange& range, Func&& func)
+	{
+		if (range.NumChunks == 0)
+			return;
+
+		if (range.NumChunks == 1)
+			return func(size_t(0), range.Begin(0), range.End(0));
+
+		WorkerPool::Instance().Run(range, func);
+	}
+
+	template<class Func>
+	inline void ParallelFor(size_t count, size_t grain, Func&& func)
+	{
+		ParallelFor(SplitRange(count, grain), std::forward<Func>(func));
+	}
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+namespace LCN
+{
+	/////////////////////
+	//-- Ring buffer --//
+	/////////////////////
+
+	// Bounded lock-free queue (sequence numbered cells).
+	// Any number of producers and consumers may use it concurrently, so it covers
+	// the SPSC and MPSC cases. Neither side ever blocks : TryPush fails when the
+	// buffer is full and TryPop fails when it is empty.
+	template<typename T, size_t Capacity>
+	class RingBuffer
+	{
+	public:
+		static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2");
+		static_assert(std::is_default_constructible_v<T>);
+
+		using ValType = T;
+
+		enum : size_t
+		{
+			CacheLineSize = 64
+		};
+
+		RingBuffer();
+
+		RingBuffer(const RingBuffer&) = delete;
+		RingBuffer& operator=(const RingBuffer&) = delete;
+
+		bool TryPush(const T& value);
+		bool TryPush(T&& value);
+
+		bool TryPop(T& value);
+
+		// Only a hint when other threads are pushing or popping
+		size_t SizeApprox() const;
+
+	private:
+		template<class U>
+		bool Push(U&& value);
+
+		struct Cell
+		{
+			std::atomic<size_t> Sequence;
+			T                   Data;
+		};
+
+		static constexpr size_t Mask = Capacity - 1;
+
+		alignas(CacheLineSize) std::array<Cell, Capacity> m_Cells;
+		alignas(CacheLineSize) std::atomic<size_t>        m_Head;
+		alignas(CacheLineSize) std::atomic<size_t>        m_Tail;
+	};
+
+	////////////////////////
+	//-- Implementation --//
+	////////////////////////
+
+	template<typename T, size_t Capacity>
+	inline RingBuffer<T, Capacity>::RingBuffer() :
+		m_Head(0),
+		m_Tail(0)
+	{
+		for (size_t i = 0; i < Capacity; ++i)
+			m_Cells[i].Sequence.store(i, std::memory_order_relaxed);
+	}
+
+	template<typename T, size_t Capacity>
+	inline bool RingBuffer<T, Capacity>::TryPush(const T& value)
+	{
+		return Push(value);
+	}
+
+	template<typename T, size_t Capacity>
+	inline bool RingBuffer<T, Capacity>::TryPush(T&& value)
+	{
+		return Push(std::move(value));
+	}
+
+	template<typename T, size_t Capacity>
+	template<class U>
+	inline bool RingBuffer<T, Capacity>::Push(U&& value)
+	{
+		size_t pos = m_Head.load(std::memory_order_relaxed);
+
+		for (;;)
+		{
+			Cell& cell = m_Cells[pos & Mask];
+
+			size_t seq  = cell.Sequence.load(std::memory_order_acquire);
+			auto   diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+
+			if (diff == 0)
+			{
+				if (m_Head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					cell.Data = std::forward<U>(value);
+					cell.Sequence.store(pos + 1, std::memory_order_release);
+
+					return true;
+				}
+			}
+			else if (diff < 0)
+			{
+				// Full
+				return false;
+			}
+			else
+			{
+				pos = m_Head.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	template<typename T, size_t Capacity>
+	inline bool RingBuffer<T, Capacity>::TryPop(T& value)
+	{
+		size_t pos = m_Tail.load(std::memory_order_relaxed);
+
+		for (;;)
+		{
+			Cell& cell = m_Cells[pos & Mask];
+
+			size_t seq  = cell.Sequence.load(std::memory_order_acquire);
+			auto   diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+
+			if (diff == 0)
+			{
+				if (m_Tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					value = std::move(cell.Data);
+					cell.Sequence.store(pos + Capacity, std::memory_order_release);
+
+					return true;
+				}
+			}
+			else if (diff < 0)
+			{
+				// Empty
+				return false;
+			}
+			else
+			{
+				pos = m_Tail.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	template<typename T, size_t Capacity>
+	inline size_t RingBuffer<T, Capacity>::SizeApprox() const
+	{
+		size_t head = m_Head.load(std::memory_order_relaxed);
+		size_t tail = m_Tail.load(std::memory_order_relaxed);
+
+		return head >= tail ? head - tail : 0;
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace LCN
+{
+	////////////////////////
+	//-- Bit operations --//
+	////////////////////////
+
+	// Index of the lowest set bit, mask must not be 0
+	inline uint32_t CountTrailingZeros(uint64_t mask)
+	{
+#ifdef _MSC_VER
+		unsigned long idx;
+		_BitScanForward64(&idx, mask);
+		return uint32_t(idx);
+#else
+		return uint32_t(__builtin_ctzll(mask));
+#endif
+	}
+
+	inline uint32_t PopCount(uint64_t mask)
+	{
+#ifdef _MSC_VER
+		return uint32_t(__popcnt64(mask));
+#else
+		return uint32_t(__builtin_popcountll(mask));
+#endif
+	}
+
+	// Calls func(i) for every set bit i of mask, lowest first
+	template<class Func>
+	inline void ForEachSetBit(uint64_t mask, Func&& func)
+	{
+		while (mask != 0)
+		{
+			func(CountTrailingZeros(mask));
+			mask &= mask - 1;
+		}
+	}
+}
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+#include "LCN_Collisions/Source/Collisions/CollisionCore.h"
+#include "LCN_Collisions/Source/Concurrency/RingBuffer.h"
+#include "LCN_Collisions/Source/Memory/Allocator.h"
+
+namespace LCN
+{
+	/////////////////////////
+	//-- Collision event --//
+	/////////////////////////
+
+	enum class CollisionEventType : uint8_t
+	{
+		Begin,   // Pair overlaps this frame but did not last frame
+		Persist, // Pair overlaps this frame and last frame
+		End      // Pair overlapped last frame but does not anymore
+	};
+
+	template<class ResultType>
+	struct CollisionEvent
+	{
+		CollisionEventType Type;
+		uint32_t           Id1;
+		uint32_t           Id2;
+		uint64_t           Frame;
+
+		// Default constructed for End events
+		ResultType         Result;
+	};
+
+	////////////////////////////////
+	//-- Collision event stream --//
+	////////////////////////////////
+
+	// Diffs the pairs reported during a frame against the ones of the previous frame
+	// and publishes Begin/Persist/End events to a lock-free ring buffer.
+	// The stream itself is owned by one collision thread. Several streams may share
+	// one queue (MPSC), and consumers drain it with Poll/TryPop without ever blocking
+	// the producers. Events that do not fit in the queue are dropped and counted.
+	// The pair lists keep their capacity from frame to frame.
+	template<class Shape1, class Shape2, size_t Capacity = 4096, class Allocator = std::allocator<uint64_t>>
+	class CollisionEventStream
+	{
+	public:
+		using ResultType    = typename std::invoke_result_t<CollisionCompute, const Shape1&, const Shape2&>::value_type;
+		using EventType     = CollisionEvent<ResultType>;
+		using QueueType     = RingBuffer<EventType, Capacity>;
+		using AllocatorType = Allocator;
+
+		explicit CollisionEventStream(const Allocator& alloc = Allocator());
+
+		explicit CollisionEventStream(QueueType& queue, const Allocator& alloc = Allocator());
+
+		void BeginFrame();
+
+		// Runs the narrow phase on (s1, s2) and records the pair if they collide
+		bool Report(uint32_t id1, const Shape1& s1, uint32_t id2, const Shape2& s2);
+
+		// Records a pair whose collision has already been computed. With two shapes of the
+		// same type, result must be the one of the shape of smaller id against the other.
+		// A pair reported several times in a frame keeps the result of its last report.
+		void Report(uint32_t id1, uint32_t id2, const ResultType& result);
+
+		// Publishes the events of the frame, returns the number of events pushed
+		size_t EndFrame();
+
+		bool Poll(EventType& event) { return m_Queue->TryPop(event); }
+
+		QueueType& Queue() { return *m_Queue; }
+
+		uint64_t Frame()         const { return m_Frame; }
+		size_t   ActivePairs()   const { return m_PreviousKeys.size(); }
+		size_t   DroppedEvents() const { return m_DroppedEvents; }
+
+	private:
+		using KeyType = uint64_t;
+
+		struct PairType
+		{
+			KeyType    Key;
+			size_t     Order; // Index of the report in the frame
+			ResultType Result;
+		};
+
+		static constexpr bool Symmetric = std::is_same_v<Shape1, Shape2>;
+
+		static KeyType MakeKey(uint32_t id1, uint32_t id2)
+		{
+			if constexpr (Symmetric)
+				return (KeyType(std::min(id1, id2)) << 32) | KeyType(std::max(id1, id2));
+			else
+				return (KeyType(id1) << 32) | KeyType(id2);
+		}
+
+		bool Publish(CollisionEventType type, KeyType key, const ResultType& result);
+
+		std::unique_ptr<QueueType> m_OwnedQueue;
+		QueueType*                 m_Queue;
+
+		CollisionCompute m_Compute;
+
+		AllocVector<PairType, Allocator> m_CurrentPairs;
+		AllocVector<KeyType, Allocator>  m_PreviousKeys;
+		AllocVector<KeyType, Allocator>  m_NextKeys;
+
+		uint64_t m_Frame         = 0;
+		size_t   m_DroppedEvents = 0;
+	};
+
+	////////////////////////
+	//-- Implementation --//
+	////////////////////////
+
+	template<class Shape1, class Shape2, size_t Capacity, class Allocator>
+	inline CollisionEventStream<Shape1, Shape2, Capacity, Allocator>::CollisionEventStream(const Allocator& alloc) :
+		m_OwnedQueue(std::make_unique<QueueType>()),
+		m_Queue(m_OwnedQueue.get()),
+		m_CurrentPairs(alloc),
+		m_PreviousKeys(alloc),
+		m_NextKeys(alloc)
+	{}
+
+	template<class Shape1, class Shape2, size_t Capacity, class Allocator>
+	inline CollisionEventStream<Shape1, Shape2, Capacity, Allocator>::CollisionEventStream(QueueType& queue, const Allocator& alloc) :
+		m_Queue(&queue),
+		m_CurrentPairs(alloc),
+		m_PreviousKeys(alloc),
+		m_NextKeys(alloc)
+	{}
+
+	template<class Shape1, class Shape2, size_t Capacity, class Allocator>
+	inline void CollisionEventStream<Shape1, Shape2, Capacity, Allocator>::BeginFrame()
+	{
+		m_CurrentPairs.clear();
+	}
+
+	template<class Shape1, class Shape2, size_t Capacity, class Allocator>
+	inline bool CollisionEventStream<Shape1, Shape2, Capacity, Allocator>::Report(uint32_t id1, const Shape1& s1, uint32_t id2, const Shape2& s2)
+	{
+		// Same order as the key, so that the result does not depend on the order of the report
+		bool swap = false;
+
+		if constexpr (Symmetric)
+			swap = id2 < id1;
+
+		auto result = swap ? m_Compute(s2, s1) : m_Compute(s1, s2);
+
+		if (!result)
+			return false;
+
+		m_CurrentPairs.push_back(PairType{ MakeKey(id1, id2), m_CurrentPairs.size(), *result });
+
+		return true;
+	}
+
+	template<class Shape1, class Shape2, size_t Capacity, class Allocator>
+	inline void CollisionEventStream<Shape1, Shape2, Capacity, Allocator>::Report(uint32_t id1, uint32_t id2, const ResultType& result)
+	{
+		m_CurrentPairs.push_back(PairType{ MakeKey(id1, id2), m_CurrentPairs.size(), result });
+	}
+
+	template<class Shape1, class Shape2, size_t Capacity, class Allocator>
+	inline size_t CollisionEventStream<Shape1, Shape2, Capacity, Allocator>::EndFrame()
+	{
+		auto byKey = [](const PairType& a, const PairType& b) { return a.Key < b.Key || (a.Key == b.Key && a.Order < b.Order); };
+
+		// A pair reported twice in the same frame only counts once, with its last reported result.
+		// Sorted on the report order too rather than std::stable_sort, which would allocate every frame
+		std::sort(m_CurrentPairs.begin(), m_CurrentPairs.end(), byKey);
+
+		size_t numPairs = 0;
+
+		for (size_t i = 0; i < m_CurrentPairs.size(); ++i)
+		{
+			if (i + 1 == m_CurrentPairs.size() || m_CurrentPairs[i + 1].Key != m_CurrentPairs[i].Key)
+			{
+				if (numPairs != i)
+					m_CurrentPairs[numPairs] = std::move(m_CurrentPairs[i]);
+
+				++numPairs;
+			}
+		}
+
+		m_CurrentPairs.erase(m_CurrentPairs.begin() + numPairs, m_CurrentPairs.end());
+
+		m_NextKeys.clear();
+		m_NextKeys.reserve(m_CurrentPairs.size() + m_PreviousKeys.size());
+
+		size_t published = 0;
+
+		auto prev = m_PreviousKeys.cbegin();
+		auto curr = m_CurrentPairs.cbegin();
+
+		const ResultType noResult{};
+
+		while (prev != m_PreviousKeys.cend() || curr != m_CurrentPairs.cend())
+		{
+			if (curr == m_CurrentPairs.cend() || (prev != m_PreviousKeys.cend() && *prev < curr->Key))
+			{
+				// Still active for the consumers until its End is delivered
+				if (Publish(CollisionEventType::End, *prev, noResult))
+					++published;
+				else
+					m_NextKeys.push_back(*prev);
+
+				++prev;
+				continue;
+			}
+
+			bool persist = prev != m_PreviousKeys.cend() && *prev == curr->Key;
+
+			// A pair only becomes active for the consumers once its Begin is delivered
+			if (Publish(persist ? CollisionEventType::Persist : CollisionEventType::Begin, curr->Key, curr->Result))
+			{
+				++published;
+				m_NextKeys.push_back(curr->Key);
+			}
+			else if (persist)
+				m_NextKeys.push_back(curr->Key);
+
+			if (persist)
+				++prev;
+
+			++curr;
+		}
+
+		std::swap(m_PreviousKeys, m_NextKeys);
+
+		++m_Frame;
+
+		return published;
+	}
+
+	template<class Shape1, class Shape2, size_t Capacity, class Allocator>
+	inline bool CollisionEventStream<Shape1, Shape2, Capacity, Allocator>::Publish(CollisionEventType type, KeyType key, const ResultType& result)
+	{
+		EventType event{ type, uint32_t(key >> 32), uint32_t(key), m_Frame, result };
+
+		if (m_Queue->TryPush(std::move(event)))
+			return true;
+
+		++m_DroppedEvents;
+
+		return false;
+	}
+}
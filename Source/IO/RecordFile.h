@@ -0,0 +1,147 @@
+#pragma once
+
+#include <vector>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <algorithm>
+
+namespace LCN
+{
+	//////////////////////
+	//-- Record files --//
+	//////////////////////
+
+	// Buffered sequential access to binary files of trivially copyable records,
+	// written and read back in the native layout of the machine.
+	// I/O errors do not throw : IsOpen() and Good() tell whether every record so far
+	// went through, a reader at the end of a stream stays Good().
+
+	template<class Record>
+	class RecordWriter
+	{
+	public:
+		static_assert(std::is_trivially_copyable_v<Record>);
+
+		RecordWriter(const std::string& path, size_t bufferSize = 1 << 14) :
+			m_File(path, std::ios::binary | std::ios::trunc)
+		{
+			m_Buffer.reserve(bufferSize);
+		}
+
+		~RecordWriter() { Flush(); }
+
+		RecordWriter(const RecordWriter&) = delete;
+		RecordWriter& operator=(const RecordWriter&) = delete;
+
+		void Write(const Record& record)
+		{
+			m_Buffer.push_back(record);
+
+			if (m_Buffer.size() == m_Buffer.capacity())
+				Flush();
+		}
+
+		void Write(const Record* records, size_t count)
+		{
+			Flush();
+
+			m_File.write(reinterpret_cast<const char*>(records), std::streamsize(count * sizeof(Record)));
+			m_Written += count;
+		}
+
+		void Flush()
+		{
+			m_File.write(reinterpret_cast<const char*>(m_Buffer.data()), std::streamsize(m_Buffer.size() * sizeof(Record)));
+			m_File.flush();
+
+			m_Written += m_Buffer.size();
+			m_Buffer.clear();
+		}
+
+		size_t Written() const { return m_Written + m_Buffer.size(); }
+
+		bool IsOpen() const { return m_File.is_open(); }
+
+		// Buffered records are only checked once flushed
+		bool Good() const { return m_File.is_open() && m_File.good(); }
+
+	private:
+		std::ofstream       m_File;
+		std::vector<Record> m_Buffer;
+		size_t              m_Written = 0;
+	};
+
+	template<class Record>
+	class RecordReader
+	{
+	public:
+		static_assert(std::is_trivially_copyable_v<Record>);
+
+		explicit RecordReader(std::istream& stream, size_t bufferSize = 1 << 14) :
+			m_Stream(&stream)
+		{
+			m_Buffer.resize(bufferSize);
+		}
+
+		RecordReader(const std::string& path, size_t bufferSize = 1 << 14) :
+			m_File(path, std::ios::binary),
+			m_Stream(&m_File)
+		{
+			m_Buffer.resize(bufferSize);
+		}
+
+		RecordReader(const RecordReader&) = delete;
+		RecordReader& operator=(const RecordReader&) = delete;
+
+		// Next record, nullptr at the end of the stream
+		const Record* Next()
+		{
+			if (m_Cursor == m_Size && !Refill())
+				return nullptr;
+
+			return &m_Buffer[m_Cursor++];
+		}
+
+		bool IsOpen() const { return m_Stream != &m_File || m_File.is_open(); }
+
+		// False after a read error, the end of the stream is not an error
+		bool Good() const { return IsOpen() && !m_Stream->bad(); }
+
+		// Reads up to count records, returns how many were read
+		size_t Read(Record* out, size_t count)
+		{
+			size_t read = 0;
+
+			while (read < count && (m_Cursor < m_Size || Refill()))
+			{
+				const size_t n = std::min(count - read, m_Size - m_Cursor);
+
+				std::copy(m_Buffer.begin() + m_Cursor, m_Buffer.begin() + m_Cursor + n, out + read);
+
+				m_Cursor += n;
+				read     += n;
+			}
+
+			return read;
+		}
+
+	private:
+		bool Refill()
+		{
+			m_Stream->read(reinterpret_cast<char*>(m_Buffer.data()), std::streamsize(m_Buffer.size() * sizeof(Record)));
+
+			// A truncated last record is dropped
+			m_Size   = size_t(m_Stream->gcount()) / sizeof(Record);
+			m_Cursor = 0;
+
+			return m_Size != 0;
+		}
+
+		std::ifstream       m_File;
+		std::istream*       m_Stream;
+		std::vector<Record> m_Buffer;
+		size_t              m_Size   = 0;
+		size_t              m_Cursor = 0;
+	};
+}
@@ -0,0 +1,372 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+
+#include "LCN_Collisions/Source/Collisions/CollisionCore.h"
+#include "LCN_Collisions/Source/Concurrency/ParallelFor.h"
+#include "LCN_Collisions/Source/Memory/Allocator.h"
+
+namespace LCN
+{
+	//////////////////////
+	//-- Overlap pair --//
+	//////////////////////
+
+	struct OverlapPair
+	{
+		uint32_t Id1;
+		uint32_t Id2;
+	};
+
+	enum : size_t
+	{
+		IslandGrain = 4096
+	};
+
+	// Runs CollisionDetect on every candidate pair of shapes and appends the pairs that collide to out.
+	// The order of the candidates is preserved.
+	template<class Shape, class PairAllocator>
+	inline size_t
+	DetectPairs(
+		const Shape* shapes,
+		const OverlapPair* candidates,
+		size_t numCandidates,
+		std::vector<OverlapPair, PairAllocator>& out)
+	{
+		const ParallelRange range = SplitRange(numCandidates, IslandGrain);
+
+		AllocVector<uint8_t, PairAllocator> hits(numCandidates, 0, out.get_allocator());
+		AllocVector<size_t, PairAllocator>  chunkHits(range.NumChunks + 1, 0, out.get_allocator());
+
+		ParallelFor(range, [&](size_t chunk, size_t begin, size_t end)
+		{
+			CollisionDetect detect;
+
+			size_t count = 0;
+
+			for (size_t k = begin; k < end; ++k)
+			{
+				hits[k] = detect(shapes[candidates[k].Id1], shapes[candidates[k].Id2]);
+				count  += hits[k];
+			}
+
+			chunkHits[chunk + 1] = count;
+		});
+
+		const size_t first = out.size();
+
+		for (size_t c = 0; c < range.NumChunks; ++c)
+			chunkHits[c + 1] += chunkHits[c];
+
+		out.resize(first + chunkHits[range.NumChunks]);
+
+		ParallelFor(range, [&](size_t chunk, size_t begin, size_t end)
+		{
+			size_t cursor = first + chunkHits[chunk];
+
+			for (size_t k = begin; k < end; ++k)
+				if (hits[k])
+					out[cursor++] = candidates[k];
+		});
+
+		return chunkHits[range.NumChunks];
+	}
+
+	////////////////////////
+	//-- Island builder --//
+	////////////////////////
+
+	// Groups objects connected by overlap pairs into islands.
+	// Pairs are merged by a lock-free union-find shared by all threads : roots are
+	// always linked under the root of smaller index, so the root of an island is its
+	// smallest object and islands are numbered by their smallest object.
+	// Objects that are in no pair form islands of their own.
+	// An island sleeps when all its objects sleep, AwakeIslands() lists the others so
+	// that sleeping islands can be skipped without being visited.
+	// Arrays keep their capacity from one build to the next.
+	template<class Allocator = std::allocator<uint32_t>>
+	class IslandBuilder
+	{
+	public:
+		using AllocatorType = Allocator;
+
+		explicit IslandBuilder(const Allocator& alloc = Allocator());
+
+		// sleeping, when not null, holds one flag per object
+		void Build(size_t numObjects, const OverlapPair* pairs, size_t numPairs, const uint8_t* sleeping = nullptr);
+
+		template<class PairAllocator>
+		void Build(size_t numObjects, const std::vector<OverlapPair, PairAllocator>& pairs, const uint8_t* sleeping = nullptr)
+		{
+			Build(numObjects, pairs.data(), pairs.size(), sleeping);
+		}
+
+		size_t NumIslands() const { return m_MemberOffsets.size() - 1; }
+
+		// Objects of an island in increasing order
+		const uint32_t* MembersBegin(size_t island) const { return m_Members.data() + m_MemberOffsets[island]; }
+		const uint32_t* MembersEnd(size_t island)   const { return m_Members.data() + m_MemberOffsets[island + 1]; }
+		size_t          NumMembers(size_t island)   const { return m_MemberOffsets[island + 1] - m_MemberOffsets[island]; }
+
+		// Indices of the pairs of an island in increasing order
+		const uint32_t* PairsBegin(size_t island) const { return m_Pairs.data() + m_PairOffsets[island]; }
+		const uint32_t* PairsEnd(size_t island)   const { return m_Pairs.data() + m_PairOffsets[island + 1]; }
+		size_t          NumPairs(size_t island)   const { return m_PairOffsets[island + 1] - m_PairOffsets[island]; }
+
+		uint32_t IslandOf(size_t object) const { return m_IslandOf[object]; }
+
+		bool IsSleeping(size_t island) const { return !m_Awake[island]; }
+
+		const AllocVector<uint32_t, Allocator>& AwakeIslands() const { return m_AwakeIslands; }
+
+		const AllocVector<uint32_t, Allocator>& MemberOffsets() const { return m_MemberOffsets; }
+		const AllocVector<uint32_t, Allocator>& Members()       const { return m_Members; }
+		const AllocVector<uint32_t, Allocator>& PairOffsets()   const { return m_PairOffsets; }
+		const AllocVector<uint32_t, Allocator>& Pairs()         const { return m_Pairs; }
+
+	private:
+		using AtomicType = std::atomic<uint32_t>;
+
+		uint32_t Find(uint32_t x);
+		void     Unite(uint32_t a, uint32_t b);
+
+		// Resizes an array of atomics, only reallocating when it grows
+		static void Reserve(AllocVector<AtomicType, Allocator>& array, size_t size, const Allocator& alloc);
+
+		// Fills offsets from per island counts and turns counts into scatter cursors
+		void Offsets(AllocVector<uint32_t, Allocator>& offsets);
+
+		// Scatters the items into per island ranges then sorts every range
+		template<class IslandOfItem>
+		void Group(size_t numItems, AllocVector<uint32_t, Allocator>& offsets, AllocVector<uint32_t, Allocator>& items, IslandOfItem&& islandOf);
+
+		Allocator m_Allocator;
+
+		AllocVector<AtomicType, Allocator> m_Parents;
+		AllocVector<AtomicType, Allocator> m_Cursors;
+
+		AllocVector<uint32_t, Allocator> m_IslandOf;
+		AllocVector<uint32_t, Allocator> m_MemberOffsets;
+		AllocVector<uint32_t, Allocator> m_Members;
+		AllocVector<uint32_t, Allocator> m_PairOffsets;
+		AllocVector<uint32_t, Allocator> m_Pairs;
+		AllocVector<uint8_t, Allocator>  m_Awake;
+		AllocVector<uint32_t, Allocator> m_AwakeIslands;
+	};
+
+	////////////////////////
+	//-- Implementation --//
+	////////////////////////
+
+	template<class Allocator>
+	inline IslandBuilder<Allocator>::IslandBuilder(const Allocator& alloc) :
+		m_Allocator(alloc),
+		m_Parents(alloc),
+		m_Cursors(alloc),
+		m_IslandOf(alloc),
+		m_MemberOffsets(1, 0, alloc),
+		m_Members(alloc),
+		m_PairOffsets(1, 0, alloc),
+		m_Pairs(alloc),
+		m_Awake(alloc),
+		m_AwakeIslands(alloc)
+	{}
+
+	template<class Allocator>
+	inline uint32_t IslandBuilder<Allocator>::Find(uint32_t x)
+	{
+		for (;;)
+		{
+			uint32_t parent = m_Parents[x].load(std::memory_order_relaxed);
+
+			if (parent == x)
+				return x;
+
+			uint32_t grandParent = m_Parents[parent].load(std::memory_order_relaxed);
+
+			// Path halving, losing the race only means the path is not shortened
+			if (parent != grandParent)
+				m_Parents[x].compare_exchange_weak(parent, grandParent, std::memory_order_relaxed);
+
+			x = grandParent;
+		}
+	}
+
+	template<class Allocator>
+	inline void IslandBuilder<Allocator>::Unite(uint32_t a, uint32_t b)
+	{
+		for (;;)
+		{
+			a = Find(a);
+			b = Find(b);
+
+			if (a == b)
+				return;
+
+			if (a < b)
+				std::swap(a, b);
+
+			// a is still a root if the exchange succeeds, linking by index never creates a cycle
+			uint32_t expected = a;
+
+			if (m_Parents[a].compare_exchange_strong(expected, b, std::memory_order_relaxed))
+				return;
+		}
+	}
+
+	template<class Allocator>
+	inline void IslandBuilder<Allocator>::Reserve(AllocVector<AtomicType, Allocator>& array, size_t size, const Allocator& alloc)
+	{
+		if (array.size() < size)
+			array = AllocVector<AtomicType, Allocator>(size, alloc);
+	}
+
+	template<class Allocator>
+	inline void IslandBuilder<Allocator>::Build(size_t numObjects, const OverlapPair* pairs, size_t numPairs, const uint8_t* sleeping)
+	{
+		Reserve(m_Parents, numObjects, m_Allocator);
+
+		const ParallelRange objects = SplitRange(numObjects, IslandGrain);
+
+		ParallelFor(objects, [&](size_t, size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+				m_Parents[i].store(uint32_t(i), std::memory_order_relaxed);
+		});
+
+		ParallelFor(numPairs, IslandGrain, [&](size_t, size_t begin, size_t end)
+		{
+			for (size_t k = begin; k < end; ++k)
+				Unite(pairs[k].Id1, pairs[k].Id2);
+		});
+
+		// Flatten, every object now points to the smallest object of its island
+		m_IslandOf.resize(numObjects);
+
+		AllocVector<uint32_t, Allocator> chunkRoots(objects.NumChunks + 1, 0, m_Allocator);
+
+		ParallelFor(objects, [&](size_t chunk, size_t begin, size_t end)
+		{
+			uint32_t roots = 0;
+
+			for (size_t i = begin; i < end; ++i)
+			{
+				m_IslandOf[i] = Find(uint32_t(i));
+				roots += m_IslandOf[i] == i;
+			}
+
+			chunkRoots[chunk + 1] = roots;
+		});
+
+		for (size_t c = 0; c < objects.NumChunks; ++c)
+			chunkRoots[c + 1] += chunkRoots[c];
+
+		const size_t numIslands = chunkRoots[objects.NumChunks];
+
+		// Island index of the roots. A root comes before the other objects of its island,
+		// so the parents can hold the root indices while the island of every object is read.
+		ParallelFor(objects, [&](size_t chunk, size_t begin, size_t end)
+		{
+			uint32_t island = chunkRoots[chunk];
+
+			for (size_t i = begin; i < end; ++i)
+				if (m_IslandOf[i] == i)
+					m_Parents[i].store(island++, std::memory_order_relaxed);
+		});
+
+		ParallelFor(objects, [&](size_t, size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+				m_IslandOf[i] = m_Parents[m_IslandOf[i]].load(std::memory_order_relaxed);
+		});
+
+		Reserve(m_Cursors, numIslands, m_Allocator);
+
+		m_MemberOffsets.resize(numIslands + 1);
+		m_PairOffsets.resize(numIslands + 1);
+
+		Group(numObjects, m_MemberOffsets, m_Members, [&](size_t i) { return m_IslandOf[i]; });
+		Group(numPairs,   m_PairOffsets,   m_Pairs,   [&](size_t k) { return m_IslandOf[pairs[k].Id1]; });
+
+		// Islands awake as soon as one of their objects is. Every island is written by
+		// the one thread that scans its members.
+		m_Awake.resize(numIslands);
+
+		ParallelFor(numIslands, IslandGrain, [&](size_t, size_t begin, size_t end)
+		{
+			for (size_t island = begin; island < end; ++island)
+			{
+				uint8_t awake = sleeping ? 0 : 1;
+
+				for (const uint32_t* m = MembersBegin(island); m != MembersEnd(island) && !awake; ++m)
+					awake = !sleeping[*m];
+
+				m_Awake[island] = awake;
+			}
+		});
+
+		m_AwakeIslands.clear();
+
+		for (size_t island = 0; island < numIslands; ++island)
+			if (m_Awake[island])
+				m_AwakeIslands.push_back(uint32_t(island));
+	}
+
+	template<class Allocator>
+	inline void IslandBuilder<Allocator>::Offsets(AllocVector<uint32_t, Allocator>& offsets)
+	{
+		const size_t numIslands = offsets.size() - 1;
+
+		offsets[0] = 0;
+
+		for (size_t island = 0; island < numIslands; ++island)
+		{
+			uint32_t count = m_Cursors[island].load(std::memory_order_relaxed);
+
+			offsets[island + 1] = offsets[island] + count;
+			m_Cursors[island].store(offsets[island], std::memory_order_relaxed);
+		}
+	}
+
+	template<class Allocator>
+	template<class IslandOfItem>
+	inline void IslandBuilder<Allocator>::Group(size_t numItems, AllocVector<uint32_t, Allocator>& offsets, AllocVector<uint32_t, Allocator>& items, IslandOfItem&& islandOf)
+	{
+		const size_t numIslands = offsets.size() - 1;
+
+		for (size_t island = 0; island < numIslands; ++island)
+			m_Cursors[island].store(0, std::memory_order_relaxed);
+
+		ParallelFor(numItems, IslandGrain, [&](size_t, size_t begin, size_t end)
+		{
+			for (size_t k = begin; k < end; ++k)
+				m_Cursors[islandOf(k)].fetch_add(1, std::memory_order_relaxed);
+		});
+
+		Offsets(offsets);
+
+		items.resize(numItems);
+
+		ParallelFor(numItems, IslandGrain, [&](size_t, size_t begin, size_t end)
+		{
+			for (size_t k = begin; k < end; ++k)
+				items[m_Cursors[islandOf(k)].fetch_add(1, std::memory_order_relaxed)] = uint32_t(k);
+		});
+
+		// Threads share the islands by number of items rather than by number of islands
+		const ParallelRange range = SplitRange(numItems, IslandGrain);
+
+		ParallelFor(range, [&](size_t, size_t begin, size_t end)
+		{
+			// Islands starting in [begin, end)
+			size_t first = size_t(std::lower_bound(offsets.begin(), offsets.end() - 1, uint32_t(begin)) - offsets.begin());
+			size_t last  = size_t(std::lower_bound(offsets.begin(), offsets.end() - 1, uint32_t(end))   - offsets.begin());
+
+			for (size_t island = first; island < last; ++island)
+				std::sort(items.begin() + offsets[island], items.begin() + offsets[island + 1]);
+		});
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <array>
+#include <utility>
+
+namespace LCN
+{
+	///////////////////////////
+	//-- Allocator helpers --//
+	///////////////////////////
+
+	// Structures of the library take one allocator parameter and rebind it for each of
+	// their arrays. Any standard compliant allocator works (std::allocator, ArenaAllocator...).
+
+	template<class Allocator, typename U>
+	using RebindAlloc = typename std::allocator_traits<Allocator>::template rebind_alloc<U>;
+
+	template<typename U, class Allocator>
+	using AllocVector = std::vector<U, RebindAlloc<Allocator, U>>;
+
+	template<typename U, class Allocator, size_t ... I>
+	inline std::array<AllocVector<U, Allocator>, sizeof...(I)> MakeVectorArray(const Allocator& alloc, std::index_sequence<I...>)
+	{
+		return { { ((void)I, AllocVector<U, Allocator>(alloc))... } };
+	}
+
+	// N empty vectors using alloc, allocators are not required to be default constructible
+	template<typename U, size_t N, class Allocator>
+	inline std::array<AllocVector<U, Allocator>, N> MakeVectorArray(const Allocator& alloc)
+	{
+		return MakeVectorArray<U>(alloc, std::make_index_sequence<N>());
+	}
+}
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <algorithm>
+
+#include "LCN_Collisions/Source/Memory/Allocator.h"
+
+namespace LCN
+{
+	/////////////////////
+	//-- Frame arena --//
+	/////////////////////
+
+	// Bump allocator meant to be reset once per frame.
+	// Memory comes from a list of blocks that are kept across resets and reused in
+	// order, so once the arena has seen its biggest frame it never calls malloc again.
+	// Deallocate only gives memory back when it is the last allocation, everything else
+	// is released by Reset. A growing vector allocates its new buffer before freeing the
+	// old one, so its old buffers are only reclaimed by Reset : reserve containers up front.
+	// An arena is not thread safe, ThreadLocal() gives one arena per thread to pass to
+	// the allocators of the containers built by that thread.
+	class FrameArena
+	{
+	public:
+		struct Stats
+		{
+			size_t Used;              // Bytes in use this frame
+			size_t Peak;              // Highest Used since construction
+			size_t Capacity;          // Bytes owned by the arena
+			size_t SystemAllocations; // Number of blocks requested to the system
+		};
+
+		explicit FrameArena(size_t blockSize = size_t(1) << 20) :
+			m_BlockSize(blockSize)
+		{}
+
+		FrameArena(const FrameArena&) = delete;
+		FrameArena& operator=(const FrameArena&) = delete;
+
+		~FrameArena()
+		{
+			for (Block& block : m_Blocks)
+				std::free(block.Data);
+		}
+
+		void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+		void Deallocate(void* ptr, size_t size);
+
+		// Every pointer handed out since the last reset becomes invalid
+		void Reset()
+		{
+			for (Block& block : m_Blocks)
+				block.Offset = 0;
+
+			m_Current = 0;
+			m_Used    = 0;
+		}
+
+		Stats GetStats() const { return Stats{ m_Used, m_Peak, m_Capacity, m_Blocks.size() }; }
+
+		static FrameArena& ThreadLocal()
+		{
+			thread_local FrameArena arena;
+
+			return arena;
+		}
+
+	private:
+		struct Block
+		{
+			std::byte* Data;
+			size_t     Size;
+			size_t     Offset;
+		};
+
+		size_t m_BlockSize;
+
+		std::vector<Block> m_Blocks;
+		size_t             m_Current = 0;
+
+		size_t m_Used     = 0;
+		size_t m_Peak     = 0;
+		size_t m_Capacity = 0;
+	};
+
+	////////////////////////
+	//-- Implementation --//
+	////////////////////////
+
+	inline void* FrameArena::Allocate(size_t size, size_t alignment)
+	{
+		size = std::max<size_t>(size, 1);
+
+		for (; m_Current < m_Blocks.size(); ++m_Current)
+		{
+			Block& block = m_Blocks[m_Current];
+
+			const uintptr_t base    = reinterpret_cast<uintptr_t>(block.Data);
+			const uintptr_t aligned = (base + block.Offset + alignment - 1) & ~uintptr_t(alignment - 1);
+			const size_t    offset  = size_t(aligned - base);
+
+			if (offset + size <= block.Size)
+			{
+				m_Used += (offset - block.Offset) + size;
+				m_Peak  = std::max(m_Peak, m_Used);
+
+				block.Offset = offset + size;
+
+				return block.Data + offset;
+			}
+
+			// Whatever is left in this block is lost until the next reset
+		}
+
+		// New block, big enough for oversized requests
+		const size_t blockSize = std::max(m_BlockSize, size + alignment);
+
+		std::byte* data = static_cast<std::byte*>(std::malloc(blockSize));
+
+		if (!data)
+			throw std::bad_alloc();
+
+		m_Blocks.push_back(Block{ data, blockSize, 0 });
+		m_Capacity += blockSize;
+		m_Current   = m_Blocks.size() - 1;
+
+		return Allocate(size, alignment);
+	}
+
+	inline void FrameArena::Deallocate(void* ptr, size_t size)
+	{
+		if (m_Current >= m_Blocks.size() || !ptr)
+			return;
+
+		Block& block = m_Blocks[m_Current];
+
+		size = std::max<size_t>(size, 1);
+
+		if (static_cast<std::byte*>(ptr) + size == block.Data + block.Offset)
+		{
+			block.Offset -= size;
+			m_Used       -= size;
+		}
+	}
+
+	/////////////////////////
+	//-- Arena allocator --//
+	/////////////////////////
+
+	// Standard allocator over a FrameArena. The arena is always explicit, so a container
+	// keeps freeing into the arena it allocated from even when it moves to another thread
+	// (the arena itself must then not be used by two threads at once).
+	// Containers using it must be emptied or dropped before the arena is reset.
+	template<typename T>
+	class ArenaAllocator
+	{
+	public:
+		using value_type = T;
+
+		using propagate_on_container_copy_assignment = std::true_type;
+		using propagate_on_container_move_assignment = std::true_type;
+		using propagate_on_container_swap            = std::true_type;
+
+		explicit ArenaAllocator(FrameArena& arena) noexcept :
+			m_Arena(&arena)
+		{}
+
+		template<typename U>
+		ArenaAllocator(const ArenaAllocator<U>& other) noexcept :
+			m_Arena(other.Arena())
+		{}
+
+		T* allocate(size_t n)
+		{
+			return static_cast<T*>(m_Arena->Allocate(n * sizeof(T), alignof(T)));
+		}
+
+		void deallocate(T* ptr, size_t n) noexcept
+		{
+			m_Arena->Deallocate(ptr, n * sizeof(T));
+		}
+
+		FrameArena* Arena() const { return m_Arena; }
+
+		template<typename U>
+		bool operator==(const ArenaAllocator<U>& other) const { return m_Arena == other.Arena(); }
+
+		template<typename U>
+		bool operator!=(const ArenaAllocator<U>& other) const { return m_Arena != other.Arena(); }
+
+	private:
+		FrameArena* m_Arena;
+	};
+}
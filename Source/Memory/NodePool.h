@@ -0,0 +1,139 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+
+namespace LCN
+{
+	///////////////////
+	//-- Node pool --//
+	///////////////////
+
+	// Fixed size object pool for nodes linked by pointers, such as the scene versions.
+	// The BVHs keep their nodes in flat arrays that are cleared but not freed on rebuild,
+	// so they do not need it.
+	// Nodes are carved out of chunks of NodesPerChunk nodes and recycled through an
+	// intrusive free list, so a tree that is rebuilt every frame with the same number
+	// of nodes never goes back to the system allocator.
+	// The pool does not know which nodes are live : nodes that are not trivially
+	// destructible must all be destroyed before the pool.
+	template<typename T, size_t NodesPerChunk = 1024>
+	class NodePool
+	{
+	public:
+		struct Stats
+		{
+			size_t Live;              // Nodes currently handed out
+			size_t Peak;              // Highest Live since construction
+			size_t Capacity;          // Nodes owned by the pool
+			size_t SystemAllocations; // Number of chunks requested to the system
+		};
+
+		NodePool() = default;
+
+		NodePool(const NodePool&) = delete;
+		NodePool& operator=(const NodePool&) = delete;
+
+		template<class ... Args>
+		T* Create(Args&& ... args);
+
+		void Destroy(T* node);
+
+		// Gives every node back to the pool without destroying them, trivially destructible nodes only
+		void Release();
+
+		Stats GetStats() const { return Stats{ m_Live, m_Peak, m_Chunks.size() * NodesPerChunk, m_Chunks.size() }; }
+
+	private:
+		union Slot
+		{
+			Slot* Next;
+			alignas(T) std::byte Storage[sizeof(T)];
+		};
+
+		using ChunkType = std::unique_ptr<Slot[]>;
+
+		void Grow();
+
+		std::vector<ChunkType> m_Chunks;
+
+		Slot*  m_FreeList = nullptr;
+		size_t m_Live     = 0;
+		size_t m_Peak     = 0;
+	};
+
+	////////////////////////
+	//-- Implementation --//
+	////////////////////////
+
+	template<typename T, size_t NodesPerChunk>
+	template<class ... Args>
+	inline T* NodePool<T, NodesPerChunk>::Create(Args&& ... args)
+	{
+		if (!m_FreeList)
+			Grow();
+
+		Slot* slot = m_FreeList;
+		m_FreeList = slot->Next;
+
+		T* node = new (slot->Storage) T(std::forward<Args>(args)...);
+
+		++m_Live;
+		m_Peak = std::max(m_Peak, m_Live);
+
+		return node;
+	}
+
+	template<typename T, size_t NodesPerChunk>
+	inline void NodePool<T, NodesPerChunk>::Destroy(T* node)
+	{
+		if (!node)
+			return;
+
+		node->~T();
+
+		Slot* slot = reinterpret_cast<Slot*>(node);
+		slot->Next = m_FreeList;
+		m_FreeList = slot;
+
+		--m_Live;
+	}
+
+	template<typename T, size_t NodesPerChunk>
+	inline void NodePool<T, NodesPerChunk>::Release()
+	{
+		static_assert(std::is_trivially_destructible_v<T>, "Nodes with a destructor must be given back with Destroy");
+
+		m_FreeList = nullptr;
+		m_Live     = 0;
+
+		for (ChunkType& chunk : m_Chunks)
+		{
+			for (size_t i = 0; i < NodesPerChunk; ++i)
+			{
+				chunk[i].Next = m_FreeList;
+				m_FreeList    = &chunk[i];
+			}
+		}
+	}
+
+	template<typename T, size_t NodesPerChunk>
+	inline void NodePool<T, NodesPerChunk>::Grow()
+	{
+		m_Chunks.push_back(std::make_unique<Slot[]>(NodesPerChunk));
+
+		Slot* chunk = m_Chunks.back().get();
+
+		// Free list in address order
+		for (size_t i = NodesPerChunk; i-- > 0;)
+		{
+			chunk[i].Next = m_FreeList;
+			m_FreeList    = &chunk[i];
+		}
+	}
+}
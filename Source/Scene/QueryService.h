@@ -0,0 +1,348 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <limits>
+#include <algorithm>
+#include <cstdint>
+
+#include "LCN_Collisions/Source/Scene/Scene.h"
+#include "LCN_Collisions/Source/Concurrency/ParallelFor.h"
+
+namespace LCN
+{
+	///////////////////////
+	//-- Query service --//
+	///////////////////////
+
+	// Runs batches of ray and box queries against a Scene on worker threads.
+	// Submit() never blocks on the scene writer : each batch acquires a snapshot when
+	// a worker picks it up and answers every query of the batch from that snapshot,
+	// whose epoch is reported with the results.
+	template<typename T, size_t Dim, size_t ChunkSize = 256, class Allocator = std::allocator<T>>
+	class QueryService
+	{
+	public:
+		using ValType   = T;
+		using SceneType = Scene<ValType, Dim, ChunkSize, Allocator>;
+		using AABBType  = AABB<ValType, Dim>;
+		using LineType  = Line<ValType, Dim>;
+
+		enum class HitKind : uint8_t
+		{
+			None,
+			AABB,
+			Sphere
+		};
+
+		// Nearest shape hit by a ray at a distance >= 0
+		struct RayHit
+		{
+			HitKind  Kind;
+			uint32_t Id;
+			ValType  Distance;
+		};
+
+		// Ids overlapping Boxes[b] are Ids[Offsets[b]] to Ids[Offsets[b + 1] - 1]
+		struct Overlaps
+		{
+			std::vector<uint32_t> Offsets;
+			std::vector<uint32_t> Ids;
+		};
+
+		struct QueryBatch
+		{
+			std::vector<LineType> Rays;
+			std::vector<AABBType> Boxes;
+		};
+
+		struct QueryResults
+		{
+			uint64_t Epoch;
+
+			std::vector<RayHit> RayHits;
+
+			Overlaps AABBs;
+			Overlaps Spheres;
+			Overlaps Lines;
+		};
+
+		explicit QueryService(const SceneType& scene, size_t numWorkers = HardwareThreads());
+		~QueryService();
+
+		QueryService(const QueryService&) = delete;
+		QueryService& operator=(const QueryService&) = delete;
+
+		std::future<QueryResults> Submit(QueryBatch batch);
+
+		// Number of batches waiting for a worker
+		size_t Pending() const;
+
+		// Answers a batch on the calling thread
+		static QueryResults Run(const SceneType& scene, const QueryBatch& batch);
+
+	private:
+		struct Job
+		{
+			QueryBatch                 Batch;
+			std::promise<QueryResults> Promise;
+		};
+
+		using SnapshotType = typename SceneType::Snapshot;
+
+		void WorkerLoop();
+
+		static RayHit CastRay(const SnapshotType& snapshot, const LineType& ray);
+
+		template<class ShapeArray, class Test>
+		static void CollectOverlaps(const ShapeArray& shapes, const AABBType& box, Overlaps& overlaps, Test&& test);
+
+		template<class Chunk>
+		static bool ChunkVSRay(const Chunk& chunk, const LineType& ray, ValType tmax);
+
+		template<class Chunk>
+		static bool ChunkVSAABB(const Chunk& chunk, const AABBType& box);
+
+		const SceneType& m_Scene;
+
+		std::vector<std::thread> m_Workers;
+		std::deque<Job>          m_Jobs;
+
+		mutable std::mutex      m_Mutex;
+		std::condition_variable m_Condition;
+
+		bool m_Stop = false;
+	};
+
+	////////////////////////
+	//-- Implementation --//
+	////////////////////////
+
+	template<typename T, size_t Dim, size_t ChunkSize, class Allocator>
+	inline QueryService<T, Dim, ChunkSize, Allocator>::QueryService(const SceneType& scene, size_t numWorkers) :
+		m_Scene(scene)
+	{
+		numWorkers = std::max<size_t>(numWorkers, 1);
+
+		m_Workers.reserve(numWorkers);
+
+		for (size_t i = 0; i < numWorkers; ++i)
+			m_Workers.emplace_back([this]() { WorkerLoop(); });
+	}
+
+	template<typename T, size_t Dim, size_t ChunkSize, class Allocator>
+	inline QueryService<T, Dim, ChunkSize, Allocator>::~QueryService()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Stop = true;
+		}
+
+		m_Condition.notify_all();
+
+		// Batches already submitted are still answered
+		for (std::thread& worker : m_Workers)
+			worker.join();
+	}
+
+	template<typename T, size_t Dim, size_t ChunkSize, class Allocator>
+	inline std::future<typename QueryService<T, Dim, ChunkSize, Allocator>::QueryResults> QueryService<T, Dim, ChunkSize, Allocator>::Submit(QueryBatch batch)
+	{
+		std::future<QueryResults> future;
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			m_Jobs.push_back(Job{ std::move(batch), std::promise<QueryResults>() });
+			future = m_Jobs.back().Promise.get_future();
+		}
+
+		m_Condition.notify_one();
+
+		return future;
+	}
+
+	template<typename T, size_t Dim, size_t ChunkSize, class Allocator>
+	inline size_t QueryService<T, Dim, ChunkSize, Allocator>::Pending() const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		return m_Jobs.size();
+	}
+
+	template<typename T, size_t Dim, size_t ChunkSize, class Allocator>
+	inline void QueryService<T, Dim, ChunkSize, Allocator>::WorkerLoop()
+	{
+		for (;;)
+		{
+			Job job;
+
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+
+				m_Condition.wait(lock, [this]() { return m_Stop || !m_Jobs.empty(); });
+
+				if (m_Jobs.empty())
+					return;
+
+				job = std::move(m_Jobs.front());
+				m_Jobs.pop_front();
+			}
+
+			try
+			{
+				job.Promise.set_value(Run(m_Scene, job.Batch));
+			}
+			catch (...)
+			{
+				job.Promise.set_exception(std::current_exception());
+			}
+		}
+	}
+
+	template<typename T, size_t Dim, size_t ChunkSize, class Allocator>
+	inline typename QueryService<T, Dim, ChunkSize, Allocator>::QueryResults QueryService<T, Dim, ChunkSize, Allocator>::Run(const SceneType& scene, const QueryBatch& batch)
+	{
+		const SnapshotType snapshot = scene.Acquire();
+
+		QueryResults results;
+
+		results.Epoch = snapshot.Epoch();
+
+		results.RayHits.reserve(batch.Rays.size());
+
+		for (const LineType& ray : batch.Rays)
+			results.RayHits.push_back(CastRay(snapshot, ray));
+
+		for (Overlaps* overlaps : { &results.AABBs, &results.Spheres, &results.Lines })
+		{
+			overlaps->Offsets.reserve(batch.Boxes.size() + 1);
+			overlaps->Offsets.push_back(0);
+		}
+
+		for (const AABBType& box : batch.Boxes)
+		{
+			CollectOverlaps(snapshot.AABBs(), box, results.AABBs, [](const AABBType& a, const AABBType& b)
+			{
+				return DetectCollision(a, b);
+			});
+
+			CollectOverlaps(snapshot.Spheres(), box, results.Spheres, [](const AABBType& a, const SphereND<ValType, Dim>& b)
+			{
+				return DetectCollision(a, b);
+			});
+
+			CollectOverlaps(snapshot.Lines(), box, results.Lines, [](const AABBType& a, const LineType& b)
+			{
+				return ComputeCollision(a, b).has_value();
+			});
+		}
+
+		return results;
+	}
+
+	template<typename T, size_t Dim, size_t ChunkSize, class Allocator>
+	inline typename QueryService<T, Dim, ChunkSize, Allocator>::RayHit QueryService<T, Dim, ChunkSize, Allocator>::CastRay(const SnapshotType& snapshot, const LineType& ray)
+	{
+		RayHit hit{ HitKind::None, 0, std::numeric_limits<ValType>::infinity() };
+
+		auto record = [&](HitKind kind, uint32_t id, const auto& result)
+		{
+			// Entry distance if the origin is outside, exit distance otherwise
+			for (const auto& intersection : result)
+			{
+				if (intersection.Distance >= ValType(0))
+				{
+					if (intersection.Distance < hit.Distance)
+						hit = RayHit{ kind, id, intersection.Distance };
+
+					return;
+				}
+			}
+		};
+
+		auto cast = [&](const auto& shapes, HitKind kind)
+		{
+			for (size_t c = 0; c < shapes.NumChunks(); ++c)
+			{
+				const auto& chunk = shapes.ChunkAt(c);
+
+				if (!ChunkVSRay(chunk, ray, hit.Distance))
+					continue;
+
+				for (size_t i = 0; i < chunk.Shapes.size(); ++i)
+				{
+					auto result = ComputeCollision(chunk.Shapes[i], ray);
+
+					if (result)
+						record(kind, uint32_t(c * ChunkSize + i), *result);
+				}
+			}
+		};
+
+		cast(snapshot.AABBs(),   HitKind::AABB);
+		cast(snapshot.Spheres(), HitKind::Sphere);
+
+		return hit;
+	}
+
+	template<typename T, size_t Dim, size_t ChunkSize, class Allocator>
+	template<class ShapeArray, class Test>
+	inline void QueryService<T, Dim, ChunkSize, Allocator>::CollectOverlaps(const ShapeArray& shapes, const AABBType& box, Overlaps& overlaps, Test&& test)
+	{
+		for (size_t c = 0; c < shapes.NumChunks(); ++c)
+		{
+			const auto& chunk = shapes.ChunkAt(c);
+
+			if (!ChunkVSAABB(chunk, box))
+				continue;
+
+			for (size_t i = 0; i < chunk.Shapes.size(); ++i)
+				if (test(box, chunk.Shapes[i]))
+					overlaps.Ids.push_back(uint32_t(c * ChunkSize + i));
+		}
+
+		overlaps.Offsets.push_back(uint32_t(overlaps.Ids.size()));
+	}
+
+	template<typename T, size_t Dim, size_t ChunkSize, class Allocator>
+	template<class Chunk>
+	inline bool QueryService<T, Dim, ChunkSize, Allocator>::ChunkVSRay(const Chunk& chunk, const LineType& ray, ValType tmax)
+	{
+		ValType tmin = ValType(0);
+
+		// Slab test, conservative when a NaN shows up (ray parallel to a face of the bounds)
+		for (size_t i = 0; i < Dim; ++i)
+		{
+			ValType t1 = (chunk.Min[i] - ray.Origin()[i]) / ray.Direction()[i];
+			ValType t2 = (chunk.Max[i] - ray.Origin()[i]) / ray.Direction()[i];
+
+			tmin = std::max(tmin, std::min(t1, t2));
+			tmax = std::min(tmax, std::max(t1, t2));
+		}
+
+		return tmin <= tmax;
+	}
+
+	template<typename T, size_t Dim, size_t ChunkSize, class Allocator>
+	template<class Chunk>
+	inline bool QueryService<T, Dim, ChunkSize, Allocator>::ChunkVSAABB(const Chunk& chunk, const AABBType& box)
+	{
+		for (size_t i = 0; i < Dim; ++i)
+			if (chunk.Max[i] < box.Min()[i] || box.Max()[i] < chunk.Min[i])
+				return false;
+
+		return true;
+	}
+
+	////////////////////////
+	//-- Shortcut types --//
+	////////////////////////
+
+	using QueryService2Df = QueryService<float, 2>;
+	using QueryService3Df = QueryService<float, 3>;
+}
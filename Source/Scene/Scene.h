@@ -0,0 +1,413 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <memory>
+#include <atomic>
+#include <limits>
+#include <thread>
+#include <cstdint>
+
+#include "LCN_Collisions/Source/Collisions/CollisionAlgorithms.h"
+#include "LCN_Collisions/Source/Memory/Allocator.h"
+#include "LCN_Collisions/Source/Memory/NodePool.h"
+
+namespace LCN
+{
+	/////////////////////
+	//-- Chunk array --//
+	/////////////////////
+
+	// Array of shapes split in fixed size chunks shared between scene versions.
+	// A version only owns the chunks it modified (copy on write), every other chunk
+	// is shared with the previous version.
+	template<class Shape, typename T, size_t Dim, size_t ChunkSize, class Allocator = std::allocator<T>>
+	class ChunkArray
+	{
+	public:
+		using ShapeType     = Shape;
+		using ValType       = T;
+		using AllocatorType = Allocator;
+
+		struct Chunk
+		{
+			explicit Chunk(const Allocator& alloc) :
+				Shapes(alloc)
+			{}
+
+			AllocVector<ShapeType, Allocator> Shapes;
+
+			// Bounds of the shapes of the chunk, infinite for lines
+			ValType Min[Dim];
+			ValType Max[Dim];
+		};
+
+		explicit ChunkArray(const Allocator& alloc = Allocator()) :
+			m_Allocator(alloc),
+			m_Chunks(alloc),
+			m_Dirty(alloc)
+		{}
+
+		size_t Size()      const { return m_Size; }
+		size_t NumChunks() const { return m_Chunks.size(); }
+
+		const Chunk& ChunkAt(size_t c) const { return *m_Chunks[c]; }
+
+		const ShapeType& operator[](size_t i) const { return m_Chunks[i / ChunkSize]->Shapes[i % ChunkSize]; }
+
+		// Writer side
+		uint32_t Add(const ShapeType& shape);
+		void     Set(size_t i, const ShapeType& shape);
+
+		// Recomputes the bounds of the modified chunks and forgets they were modified
+		void Seal();
+
+	private:
+		Chunk& Writable(size_t c);
+
+		static void Bounds(const AABB<ValType, Dim>& aabb, ValType* min, ValType* max);
+		static void Bounds(const SphereND<ValType, Dim>& sphere, ValType* min, ValType* max);
+		static void Bounds(const Line<ValType, Dim>& line, ValType* min, ValType* max);
+
+		Allocator m_Allocator;
+
+		AllocVector<std::shared_ptr<Chunk>, Allocator> m_Chunks;
+		AllocVector<bool, Allocator>                   m_Dirty;
+
+		size_t m_Size = 0;
+	};
+
+	///////////////
+	//-- Scene --//
+	///////////////
+
+	// Scene of AABBs, spheres and lines with one writer and any number of readers.
+	// The writer edits a pending version and publishes it with Publish(). Readers
+	// Acquire() a snapshot of the last published version and query it without locks
+	// while the writer keeps working. Old versions are reclaimed by epochs : a version
+	// is freed once no reader holds a snapshot acquired at or before its epoch.
+	// Versions are recycled through a node pool and chunks come from the allocator, so a
+	// scene whose size is stable stops allocating. The allocator is only used by the
+	// writer, but versions outlive a frame : a FrameArena does not fit.
+	template<typename T, size_t Dim, size_t ChunkSize = 256, class Allocator = std::allocator<T>>
+	class Scene
+	{
+	public:
+		using ValType       = T;
+		using AABBType      = AABB<ValType, Dim>;
+		using SphereType    = SphereND<ValType, Dim>;
+		using LineType      = Line<ValType, Dim>;
+		using AllocatorType = Allocator;
+
+		template<class Shape>
+		using ChunkArrayType = ChunkArray<Shape, ValType, Dim, ChunkSize, Allocator>;
+
+		enum : size_t
+		{
+			MaxReaders = 64
+		};
+
+		struct Version
+		{
+			explicit Version(const Allocator& alloc) :
+				Epoch(0),
+				AABBs(alloc),
+				Spheres(alloc),
+				Lines(alloc)
+			{}
+
+			uint64_t Epoch;
+
+			ChunkArrayType<AABBType>   AABBs;
+			ChunkArrayType<SphereType> Spheres;
+			ChunkArrayType<LineType>   Lines;
+		};
+
+		class Snapshot
+		{
+		public:
+			Snapshot(const Snapshot&) = delete;
+			Snapshot& operator=(const Snapshot&) = delete;
+
+			Snapshot(Snapshot&& other) noexcept :
+				m_Version(other.m_Version),
+				m_Slot(other.m_Slot)
+			{
+				other.m_Slot = nullptr;
+			}
+
+			~Snapshot()
+			{
+				if (m_Slot)
+					m_Slot->store(0, std::memory_order_release);
+			}
+
+			uint64_t Epoch() const { return m_Version->Epoch; }
+
+			const ChunkArrayType<AABBType>&   AABBs()   const { return m_Version->AABBs; }
+			const ChunkArrayType<SphereType>& Spheres() const { return m_Version->Spheres; }
+			const ChunkArrayType<LineType>&   Lines()   const { return m_Version->Lines; }
+
+		private:
+			friend class Scene;
+
+			Snapshot(const Version* version, std::atomic<uint64_t>* slot) :
+				m_Version(version),
+				m_Slot(slot)
+			{}
+
+			const Version*         m_Version;
+			std::atomic<uint64_t>* m_Slot;
+		};
+
+		explicit Scene(const Allocator& alloc = Allocator());
+		~Scene();
+
+		Scene(const Scene&) = delete;
+		Scene& operator=(const Scene&) = delete;
+
+		// Writer side, changes are only visible after Publish
+		uint32_t AddAABB(const AABBType& aabb)        { return m_Pending->AABBs.Add(aabb); }
+		uint32_t AddSphere(const SphereType& sphere)  { return m_Pending->Spheres.Add(sphere); }
+		uint32_t AddLine(const LineType& line)        { return m_Pending->Lines.Add(line); }
+
+		void SetAABB(uint32_t id, const AABBType& aabb)       { m_Pending->AABBs.Set(id, aabb); }
+		void SetSphere(uint32_t id, const SphereType& sphere) { m_Pending->Spheres.Set(id, sphere); }
+		void SetLine(uint32_t id, const LineType& line)       { m_Pending->Lines.Set(id, line); }
+
+		// Returns the epoch of the published version
+		uint64_t Publish();
+
+		// Frees the retired versions no reader can see anymore, returns how many are left
+		size_t Reclaim();
+
+		// Reader side, lock-free (spins only when MaxReaders snapshots are alive)
+		Snapshot Acquire() const;
+
+		uint64_t Epoch() const { return m_Epoch.load(std::memory_order_acquire); }
+
+	private:
+		struct alignas(64) ReaderSlot
+		{
+			std::atomic<uint64_t> Epoch{ 0 };
+		};
+
+		std::atomic<const Version*> m_Current;
+		std::atomic<uint64_t>       m_Epoch;
+
+		NodePool<Version, 16> m_Versions;
+
+		Version*                         m_Pending;
+		AllocVector<Version*, Allocator> m_Retired;
+
+		mutable std::array<ReaderSlot, MaxReaders> m_Readers;
+	};
+
+	////////////////////////
+	//-- Implementation --//
+	////////////////////////
+
+	template<class Shape, typename T, size_t Dim, size_t ChunkSize, class Allocator>
+	inline typename ChunkArray<Shape, T, Dim, ChunkSize, Allocator>::Chunk& ChunkArray<Shape, T, Dim, ChunkSize, Allocator>::Writable(size_t c)
+	{
+		if (!m_Dirty[c])
+		{
+			m_Chunks[c] = std::allocate_shared<Chunk>(m_Allocator, *m_Chunks[c]);
+			m_Dirty[c]  = true;
+		}
+
+		return *m_Chunks[c];
+	}
+
+	template<class Shape, typename T, size_t Dim, size_t ChunkSize, class Allocator>
+	inline uint32_t ChunkArray<Shape, T, Dim, ChunkSize, Allocator>::Add(const ShapeType& shape)
+	{
+		if (m_Size % ChunkSize == 0)
+		{
+			m_Chunks.push_back(std::allocate_shared<Chunk>(m_Allocator, m_Allocator));
+			m_Chunks.back()->Shapes.reserve(ChunkSize);
+			m_Dirty.push_back(true);
+		}
+
+		Writable(m_Size / ChunkSize).Shapes.push_back(shape);
+
+		return uint32_t(m_Size++);
+	}
+
+	template<class Shape, typename T, size_t Dim, size_t ChunkSize, class Allocator>
+	inline void ChunkArray<Shape, T, Dim, ChunkSize, Allocator>::Set(size_t i, const ShapeType& shape)
+	{
+		Writable(i / ChunkSize).Shapes[i % ChunkSize] = shape;
+	}
+
+	template<class Shape, typename T, size_t Dim, size_t ChunkSize, class Allocator>
+	inline void ChunkArray<Shape, T, Dim, ChunkSize, Allocator>::Seal()
+	{
+		for (size_t c = 0; c < m_Chunks.size(); ++c)
+		{
+			if (!m_Dirty[c])
+				continue;
+
+			Chunk& chunk = *m_Chunks[c];
+
+			for (size_t i = 0; i < Dim; ++i)
+			{
+				chunk.Min[i] =  std::numeric_limits<ValType>::infinity();
+				chunk.Max[i] = -std::numeric_limits<ValType>::infinity();
+			}
+
+			for (const ShapeType& shape : chunk.Shapes)
+			{
+				ValType min[Dim], max[Dim];
+
+				Bounds(shape, min, max);
+
+				for (size_t i = 0; i < Dim; ++i)
+				{
+					chunk.Min[i] = std::min(chunk.Min[i], min[i]);
+					chunk.Max[i] = std::max(chunk.Max[i], max[i]);
+				}
+			}
+
+			m_Dirty[c] = false;
+		}
+	}
+
+	template<class Shape, typename T, size_t Dim, size_t ChunkSize, class Allocator>
+	inline void ChunkArray<Shape, T, Dim, ChunkSize, Allocator>::Bounds(const AABB<ValType, Dim>& aabb, ValType* min, ValType* max)
+	{
+		for (size_t i = 0; i < Dim; ++i)
+		{
+			min[i] = aabb.Min()[i];
+			max[i] = aabb.Max()[i];
+		}
+	}
+
+	template<class Shape, typename T, size_t Dim, size_t ChunkSize, class Allocator>
+	inline void ChunkArray<Shape, T, Dim, ChunkSize, Allocator>::Bounds(const SphereND<ValType, Dim>& sphere, ValType* min, ValType* max)
+	{
+		for (size_t i = 0; i < Dim; ++i)
+		{
+			min[i] = sphere.Center()[i] - sphere.Radius();
+			max[i] = sphere.Center()[i] + sphere.Radius();
+		}
+	}
+
+	template<class Shape, typename T, size_t Dim, size_t ChunkSize, class Allocator>
+	inline void ChunkArray<Shape, T, Dim, ChunkSize, Allocator>::Bounds(const Line<ValType, Dim>&, ValType* min, ValType* max)
+	{
+		for (size_t i = 0; i < Dim; ++i)
+		{
+			min[i] = -std::numeric_limits<ValType>::infinity();
+			max[i] =  std::numeric_limits<ValType>::infinity();
+		}
+	}
+
+	template<typename T, size_t Dim, size_t ChunkSize, class Allocator>
+	inline Scene<T, Dim, ChunkSize, Allocator>::Scene(const Allocator& alloc) :
+		m_Epoch(1),
+		m_Retired(alloc)
+	{
+		Version* first = m_Versions.Create(alloc);
+		first->Epoch = 1;
+
+		m_Pending = m_Versions.Create(*first);
+		m_Current.store(first, std::memory_order_release);
+	}
+
+	template<typename T, size_t Dim, size_t ChunkSize, class Allocator>
+	inline Scene<T, Dim, ChunkSize, Allocator>::~Scene()
+	{
+		// Versions have to be destroyed before their pool
+		for (Version* version : m_Retired)
+			m_Versions.Destroy(version);
+
+		m_Versions.Destroy(m_Pending);
+		m_Versions.Destroy(const_cast<Version*>(m_Current.load(std::memory_order_acquire)));
+	}
+
+	template<typename T, size_t Dim, size_t ChunkSize, class Allocator>
+	inline uint64_t Scene<T, Dim, ChunkSize, Allocator>::Publish()
+	{
+		const uint64_t epoch = m_Epoch.load(std::memory_order_relaxed) + 1;
+
+		m_Pending->Epoch = epoch;
+		m_Pending->AABBs.Seal();
+		m_Pending->Spheres.Seal();
+		m_Pending->Lines.Seal();
+
+		// The next pending version shares every chunk with the published one
+		Version* next = m_Versions.Create(*m_Pending);
+
+		const Version* previous = m_Current.exchange(m_Pending, std::memory_order_seq_cst);
+		m_Epoch.store(epoch, std::memory_order_seq_cst);
+
+		m_Pending = next;
+		m_Retired.push_back(const_cast<Version*>(previous));
+
+		Reclaim();
+
+		return epoch;
+	}
+
+	template<typename T, size_t Dim, size_t ChunkSize, class Allocator>
+	inline size_t Scene<T, Dim, ChunkSize, Allocator>::Reclaim()
+	{
+		uint64_t minEpoch = std::numeric_limits<uint64_t>::max();
+
+		for (const ReaderSlot& slot : m_Readers)
+		{
+			uint64_t epoch = slot.Epoch.load(std::memory_order_seq_cst);
+
+			if (epoch != 0)
+				minEpoch = std::min(minEpoch, epoch);
+		}
+
+		// A reader that registered epoch e may be using any version from e on
+		auto end = std::remove_if(m_Retired.begin(), m_Retired.end(), [&](Version* version)
+		{
+			if (version->Epoch >= minEpoch)
+				return false;
+
+			m_Versions.Destroy(version);
+
+			return true;
+		});
+
+		m_Retired.erase(end, m_Retired.end());
+
+		return m_Retired.size();
+	}
+
+	template<typename T, size_t Dim, size_t ChunkSize, class Allocator>
+	inline typename Scene<T, Dim, ChunkSize, Allocator>::Snapshot Scene<T, Dim, ChunkSize, Allocator>::Acquire() const
+	{
+		for (;;)
+		{
+			for (ReaderSlot& slot : m_Readers)
+			{
+				uint64_t expected = 0;
+				uint64_t epoch    = m_Epoch.load(std::memory_order_seq_cst);
+
+				if (slot.Epoch.load(std::memory_order_relaxed) != 0)
+					continue;
+
+				if (!slot.Epoch.compare_exchange_strong(expected, epoch, std::memory_order_seq_cst))
+					continue;
+
+				// Published before the epoch was read, so at least as recent as the registered epoch
+				return Snapshot(m_Current.load(std::memory_order_seq_cst), &slot.Epoch);
+			}
+
+			std::this_thread::yield();
+		}
+	}
+
+	////////////////////////
+	//-- Shortcut types --//
+	////////////////////////
+
+	using Scene2Df = Scene<float, 2>;
+	using Scene3Df = Scene<float, 3>;
+}
@@ -0,0 +1,839 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <optional>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+#include <Utilities/Source/ErrorHandling.h>
+
+#include "LCN_Collisions/Source/Shapes/Hyperplane.h"
+#include "LCN_Collisions/Source/Shapes/AABB.h"
+#include "LCN_Collisions/Source/Shapes/Line.h"
+#include "LCN_Collisions/Source/Collisions/CollisionAlgorithms.h"
+#include "LCN_Collisions/Source/Memory/Allocator.h"
+
+namespace LCN
+{
+	template<typename T, size_t Dim, class Allocator = std::allocator<T>>
+	class ConvexPolytope;
+
+	////////////////////////////////
+	//-- ConvexPolytope vs Line --//
+	////////////////////////////////
+
+	// Same layout as AABBVSLine, face ids are plane indices
+	template<typename T, size_t Dim>
+	class CollisionResult<ConvexPolytope<T, Dim>, Line<T, Dim>>
+	{
+	public:
+		using ValType     = T;
+		using HVectorType = HVectorND<ValType, Dim>;
+
+		static constexpr size_t NoFace = std::numeric_limits<size_t>::max();
+
+		struct IntersectionType
+		{
+			size_t      FaceId;
+			HVectorType Point;
+			ValType     Distance;
+		};
+
+		using ConstIterator = typename std::array<IntersectionType, 2>::const_iterator;
+
+		CollisionResult() :
+			m_Intersections{ IntersectionType(), IntersectionType() }
+		{}
+
+		CollisionResult(const IntersectionType& entry, const IntersectionType& exit) :
+			m_Intersections{ entry, exit }
+		{}
+
+		const IntersectionType& operator[](size_t i) const { return m_Intersections[i]; }
+
+		ConstIterator begin() const { return m_Intersections.begin(); }
+		ConstIterator end()   const { return m_Intersections.end(); }
+
+	private:
+		std::array<IntersectionType, 2> m_Intersections;
+	};
+
+	template<typename T, size_t Dim>
+	using ConvexPolytopeVSLine = CollisionResult<ConvexPolytope<T, Dim>, Line<T, Dim>>;
+
+	/////////////////////////
+	//-- Convex polytope --//
+	/////////////////////////
+
+	// Intersection of the half-spaces behind a set of hyperplanes, normals pointing outwards.
+	// Planes are stored as structure of arrays (unit normals and offsets, n.x <= offset
+	// inside), padded to a multiple of LaneWidth with planes that every point is behind.
+	// The vertices, bounds and, in 3D, edge directions are computed at construction for
+	// the exact AABB test. An unbounded polytope also gets the extreme rays of its
+	// recession cone, which extend its bounds and projections to infinity. When the
+	// normals do not span the space (a slab, no plane at all...) the polytope contains
+	// whole lines and has no vertex : its bounds and projections are infinite and the
+	// AABB tests only rely on the planes, the exact one being as conservative as the other.
+	// Vertices of a polytope given by planes are enumerated from every combination of
+	// Dim planes, O(n^(Dim + 1)) : at most MaxPlanes planes. Built from an AABB, the
+	// corners are taken directly instead.
+	template<typename T, size_t Dim, class Allocator>
+	class ConvexPolytope
+	{
+	public:
+		using ValType        = T;
+		using HyperplaneType = Hyperplane<ValType, Dim>;
+		using AABBType       = AABB<ValType, Dim>;
+		using AllocatorType  = Allocator;
+
+		static constexpr size_t LaneWidth = 32 / sizeof(ValType);
+
+		// About 40k candidate vertices in 3D
+		static constexpr size_t MaxPlanes = 64;
+
+		// Throws std::length_error with more than MaxPlanes planes
+		ConvexPolytope(const std::vector<HyperplaneType>& planes, const Allocator& alloc = Allocator());
+
+		explicit ConvexPolytope(const AABBType& box, const Allocator& alloc = Allocator());
+
+		size_t NumPlanes() const { return m_NumPlanes; }
+		size_t NumBlocks() const { return m_Offsets.size() / LaneWidth; }
+
+		HyperplaneType Plane(size_t p) const;
+
+		// Padded arrays, NumBlocks() * LaneWidth long
+		const ValType* Normals(size_t axis) const { return m_Normals[axis].data(); }
+		const ValType* Offsets()            const { return m_Offsets.data(); }
+
+		size_t         NumVertices()         const { return m_Vertices[0].size(); }
+		const ValType* Vertices(size_t axis) const { return m_Vertices[axis].data(); }
+
+		// Edge directions, only computed in 3D. Empty for a box, whose edges are its face normals.
+		const AllocVector<std::array<ValType, Dim>, Allocator>& EdgeDirections() const { return m_Edges; }
+
+		// Unit directions along which the polytope is infinite, empty when bounded or when it contains lines
+		const AllocVector<std::array<ValType, Dim>, Allocator>& Rays() const { return m_Rays; }
+
+		bool ContainsLines() const { return m_ContainsLines; }
+		bool Bounded()       const { return m_Rays.empty() && !m_ContainsLines; }
+
+		// Infinite on the open sides of an unbounded polytope
+		const ValType* Min() const { return m_Min; }
+		const ValType* Max() const { return m_Max; }
+
+		bool Contains(const Point<ValType, Dim>& point) const;
+
+		// Range of the projections of the polytope on an axis
+		void Project(const ValType* axis, ValType& min, ValType& max) const;
+
+	private:
+		void AddPlane(const ValType* normal, ValType offset);
+		void Finalize();
+
+		void ComputeVertices();
+		void BoxVertices(const AABBType& box);
+
+		// Calls func(combination) for every combination of K indices out of n, in lexicographic order
+		template<size_t K, class Func>
+		static void ForEachCombination(size_t n, Func&& func);
+
+		// Gaussian elimination with partial pivoting of the augmented matrix m, false when singular
+		static bool Solve(ValType (&m)[Dim][Dim + 1], ValType (&x)[Dim]);
+
+		// Tolerance on the dot products of unit directions
+		static ValType DirectionEpsilon() { return std::sqrt(std::numeric_limits<ValType>::epsilon()); }
+
+		// Rounding error on the components of a unit direction, below which a ray does not open a side
+		static ValType DirectionRounding() { return std::numeric_limits<ValType>::epsilon() * ValType(64); }
+
+		Allocator m_Allocator;
+		size_t    m_NumPlanes = 0;
+
+		std::array<AllocVector<ValType, Allocator>, Dim> m_Normals;
+		AllocVector<ValType, Allocator>                  m_Offsets;
+
+		std::array<AllocVector<ValType, Allocator>, Dim> m_Vertices;
+		AllocVector<std::array<ValType, Dim>, Allocator> m_Edges;
+		AllocVector<std::array<ValType, Dim>, Allocator> m_Rays;
+		bool                                             m_ContainsLines = false;
+
+		ValType m_Min[Dim];
+		ValType m_Max[Dim];
+	};
+
+	////////////////////////
+	//-- Implementation --//
+	////////////////////////
+
+	template<typename T, size_t Dim, class Allocator>
+	inline ConvexPolytope<T, Dim, Allocator>::ConvexPolytope(const std::vector<HyperplaneType>& planes, const Allocator& alloc) :
+		m_Allocator(alloc),
+		m_Normals(MakeVectorArray<ValType, Dim>(alloc)),
+		m_Offsets(alloc),
+		m_Vertices(MakeVectorArray<ValType, Dim>(alloc)),
+		m_Edges(alloc),
+		m_Rays(alloc)
+	{
+		if (planes.size() > MaxPlanes)
+			throw std::length_error("ConvexPolytope : more than MaxPlanes planes");
+
+		for (const HyperplaneType& plane : planes)
+		{
+			ValType normal[Dim];
+			ValType offset = ValType(0);
+
+			for (size_t i = 0; i < Dim; ++i)
+			{
+				normal[i] = plane.Normal()[i];
+				offset   += normal[i] * plane.Origin()[i];
+			}
+
+			AddPlane(normal, offset);
+		}
+
+		ComputeVertices();
+		Finalize();
+	}
+
+	template<typename T, size_t Dim, class Allocator>
+	inline ConvexPolytope<T, Dim, Allocator>::ConvexPolytope(const AABBType& box, const Allocator& alloc) :
+		m_Allocator(alloc),
+		m_Normals(MakeVectorArray<ValType, Dim>(alloc)),
+		m_Offsets(alloc),
+		m_Vertices(MakeVectorArray<ValType, Dim>(alloc)),
+		m_Edges(alloc),
+		m_Rays(alloc)
+	{
+		// Same face ids as AABBVSLine : -x, -y, ..., +y, +x
+		for (size_t f = 0; f < 2 * Dim; ++f)
+		{
+			const size_t axis = f < Dim ? f : 2 * Dim - 1 - f;
+			const ValType sign = f < Dim ? ValType(-1) : ValType(1);
+
+			ValType normal[Dim] = {};
+			normal[axis] = sign;
+
+			AddPlane(normal, sign * (f < Dim ? box.Min()[axis] : box.Max()[axis]));
+		}
+
+		BoxVertices(box);
+		Finalize();
+	}
+
+	template<typename T, size_t Dim, class Allocator>
+	inline void ConvexPolytope<T, Dim, Allocator>::AddPlane(const ValType* normal, ValType offset)
+	{
+		ValType norm = ValType(0);
+
+		for (size_t i = 0; i < Dim; ++i)
+			norm += normal[i] * normal[i];
+
+		norm = std::sqrt(norm);
+
+		ASSERT(norm > ValType(0));
+
+		for (size_t i = 0; i < Dim; ++i)
+			m_Normals[i].push_back(normal[i] / norm);
+
+		m_Offsets.push_back(offset / norm);
+
+		++m_NumPlanes;
+	}
+
+	template<typename T, size_t Dim, class Allocator>
+	inline void ConvexPolytope<T, Dim, Allocator>::Finalize()
+	{
+		for (size_t i = 0; i < Dim; ++i)
+		{
+			m_Min[i] =  std::numeric_limits<ValType>::infinity();
+			m_Max[i] = -std::numeric_limits<ValType>::infinity();
+
+			for (ValType v : m_Vertices[i])
+			{
+				m_Min[i] = std::min(m_Min[i], v);
+				m_Max[i] = std::max(m_Max[i], v);
+			}
+
+			for (const auto& ray : m_Rays)
+			{
+				if (ray[i] >  DirectionRounding())
+					m_Max[i] =  std::numeric_limits<ValType>::infinity();
+
+				if (ray[i] < -DirectionRounding())
+					m_Min[i] = -std::numeric_limits<ValType>::infinity();
+			}
+
+			if (m_ContainsLines)
+			{
+				m_Min[i] = -std::numeric_limits<ValType>::infinity();
+				m_Max[i] =  std::numeric_limits<ValType>::infinity();
+			}
+		}
+
+		// Null normal and offset 1 : every point is 1 behind the padding planes
+		const size_t padded = (m_NumPlanes + LaneWidth - 1) / LaneWidth * LaneWidth;
+
+		for (auto& normals : m_Normals)
+			normals.resize(padded, ValType(0));
+
+		m_Offsets.resize(padded, ValType(1));
+	}
+
+	template<typename T, size_t Dim, class Allocator>
+	template<size_t K, class Func>
+	inline void ConvexPolytope<T, Dim, Allocator>::ForEachCombination(size_t n, Func&& func)
+	{
+		if (n < K)
+			return;
+
+		std::array<size_t, K> combination;
+
+		for (size_t i = 0; i < K; ++i)
+			combination[i] = i;
+
+		for (;;)
+		{
+			func(static_cast<const std::array<size_t, K>&>(combination));
+
+			size_t i = K;
+
+			while (i > 0 && combination[i - 1] == n - K + i - 1)
+				--i;
+
+			if (i == 0)
+				return;
+
+			++combination[i - 1];
+
+			for (size_t k = i; k < K; ++k)
+				combination[k] = combination[k - 1] + 1;
+		}
+	}
+
+	template<typename T, size_t Dim, class Allocator>
+	inline bool ConvexPolytope<T, Dim, Allocator>::Solve(ValType (&m)[Dim][Dim + 1], ValType (&x)[Dim])
+	{
+		for (size_t c = 0; c < Dim; ++c)
+		{
+			size_t pivot = c;
+
+			for (size_t r = c + 1; r < Dim; ++r)
+				if (std::abs(m[r][c]) > std::abs(m[pivot][c]))
+					pivot = r;
+
+			if (std::abs(m[pivot][c]) < ValType(1e-6))
+				return false;
+
+			for (size_t k = 0; k <= Dim; ++k)
+				std::swap(m[c][k], m[pivot][k]);
+
+			for (size_t r = 0; r < Dim; ++r)
+			{
+				if (r == c)
+					continue;
+
+				const ValType factor = m[r][c] / m[c][c];
+
+				for (size_t k = c; k <= Dim; ++k)
+					m[r][k] -= factor * m[c][k];
+			}
+		}
+
+		for (size_t i = 0; i < Dim; ++i)
+			x[i] = m[i][Dim] / m[i][i];
+
+		return true;
+	}
+
+	template<typename T, size_t Dim, class Allocator>
+	inline void ConvexPolytope<T, Dim, Allocator>::ComputeVertices()
+	{
+		const size_t numPlanes = m_NumPlanes;
+
+		// Tolerance relative to the size of the polytope
+		ValType scale = ValType(1);
+
+		for (ValType offset : m_Offsets)
+			scale = std::max(scale, std::abs(offset));
+
+		const ValType epsilon = scale * std::numeric_limits<ValType>::epsilon() * ValType(64);
+
+		auto distance = [&](const ValType* x, size_t p)
+		{
+			ValType d = -m_Offsets[p];
+
+			for (size_t i = 0; i < Dim; ++i)
+				d += m_Normals[i][p] * x[i];
+
+			return d;
+		};
+
+		auto slope = [&](const std::array<ValType, Dim>& direction, size_t p)
+		{
+			ValType d = ValType(0);
+
+			for (size_t i = 0; i < Dim; ++i)
+				d += m_Normals[i][p] * direction[i];
+
+			return d;
+		};
+
+		// Vertices : every combination of Dim planes meeting on a single point behind every plane.
+		// The normals span the space as soon as one combination is not singular.
+		bool spans = false;
+
+		ForEachCombination<Dim>(numPlanes, [&](const std::array<size_t, Dim>& combination)
+		{
+			ValType m[Dim][Dim + 1];
+			ValType x[Dim];
+
+			for (size_t r = 0; r < Dim; ++r)
+			{
+				for (size_t c = 0; c < Dim; ++c)
+					m[r][c] = m_Normals[c][combination[r]];
+
+				m[r][Dim] = m_Offsets[combination[r]];
+			}
+
+			if (!Solve(m, x))
+				return;
+
+			spans = true;
+
+			for (size_t p = 0; p < numPlanes; ++p)
+				if (distance(x, p) > epsilon)
+					return;
+
+			for (size_t i = 0; i < Dim; ++i)
+				m_Vertices[i].push_back(x[i]);
+		});
+
+		m_ContainsLines = !spans;
+
+		// Extreme rays of the recession cone {d : n.d <= 0 for every plane}, on the line where
+		// Dim - 1 planes are parallel to d. Without vertex, the polytope is empty or contains lines.
+		if (NumVertices() > 0)
+		{
+			ForEachCombination<Dim - 1>(numPlanes, [&](const std::array<size_t, Dim - 1>& combination)
+			{
+				// Direction orthogonal to the normals of the combination, found by adding one axis with a unit value
+				for (size_t axis = 0; axis < Dim; ++axis)
+				{
+					ValType m[Dim][Dim + 1];
+					ValType x[Dim];
+
+					for (size_t r = 0; r + 1 < Dim; ++r)
+					{
+						for (size_t c = 0; c < Dim; ++c)
+							m[r][c] = m_Normals[c][combination[r]];
+
+						m[r][Dim] = ValType(0);
+					}
+
+					for (size_t c = 0; c <= Dim; ++c)
+						m[Dim - 1][c] = ValType(c == axis || c == Dim);
+
+					if (!Solve(m, x))
+						continue;
+
+					ValType norm = ValType(0);
+
+					for (size_t i = 0; i < Dim; ++i)
+						norm += x[i] * x[i];
+
+					norm = std::sqrt(norm);
+
+					for (const ValType sign : { ValType(1), ValType(-1) })
+					{
+						std::array<ValType, Dim> ray;
+
+						for (size_t i = 0; i < Dim; ++i)
+							ray[i] = sign * x[i] / norm;
+
+						bool isRay = true;
+
+						for (size_t p = 0; p < numPlanes && isRay; ++p)
+							isRay = slope(ray, p) <= DirectionEpsilon();
+
+						// Several combinations give the same ray at a degenerate vertex
+						for (const auto& other : m_Rays)
+						{
+							ValType cosine = ValType(0);
+
+							for (size_t i = 0; i < Dim; ++i)
+								cosine += ray[i] * other[i];
+
+							isRay &= cosine < ValType(1) - DirectionEpsilon();
+						}
+
+						if (isRay)
+							m_Rays.push_back(ray);
+					}
+
+					break;
+				}
+			});
+		}
+
+		if constexpr (Dim == 3)
+		{
+			// Two planes meet on an edge when they share two distinct vertices, or a vertex and a ray
+			for (size_t a = 0; a < numPlanes; ++a)
+			{
+				for (size_t b = a + 1; b < numPlanes; ++b)
+				{
+					ValType first[Dim];
+					bool    found = false;
+					bool    edge  = false;
+
+					for (size_t v = 0; v < NumVertices() && !edge; ++v)
+					{
+						const ValType x[Dim] = { m_Vertices[0][v], m_Vertices[1][v], m_Vertices[2][v] };
+
+						if (std::abs(distance(x, a)) > epsilon || std::abs(distance(x, b)) > epsilon)
+							continue;
+
+						if (!found)
+						{
+							std::copy(x, x + Dim, first);
+							found = true;
+						}
+						else
+							edge = std::abs(x[0] - first[0]) + std::abs(x[1] - first[1]) + std::abs(x[2] - first[2]) > epsilon;
+					}
+
+					// Unbounded edge : from a vertex along a ray parallel to both planes
+					for (size_t r = 0; r < m_Rays.size() && found && !edge; ++r)
+						edge = std::abs(slope(m_Rays[r], a)) <= DirectionEpsilon() && std::abs(slope(m_Rays[r], b)) <= DirectionEpsilon();
+
+					if (!edge)
+						continue;
+
+					m_Edges.push_back({
+						m_Normals[1][a] * m_Normals[2][b] - m_Normals[2][a] * m_Normals[1][b],
+						m_Normals[2][a] * m_Normals[0][b] - m_Normals[0][a] * m_Normals[2][b],
+						m_Normals[0][a] * m_Normals[1][b] - m_Normals[1][a] * m_Normals[0][b] });
+				}
+			}
+		}
+	}
+
+	template<typename T, size_t Dim, class Allocator>
+	inline void ConvexPolytope<T, Dim, Allocator>::BoxVertices(const AABBType& box)
+	{
+		// Bit i of the corner index selects the max on axis i
+		for (size_t corner = 0; corner < (size_t(1) << Dim); ++corner)
+			for (size_t i = 0; i < Dim; ++i)
+				m_Vertices[i].push_back((corner >> i) & 1 ? box.Max()[i] : box.Min()[i]);
+	}
+
+	template<typename T, size_t Dim, class Allocator>
+	inline typename ConvexPolytope<T, Dim, Allocator>::HyperplaneType ConvexPolytope<T, Dim, Allocator>::Plane(size_t p) const
+	{
+		VectorND<ValType, Dim> origin, normal;
+
+		for (size_t i = 0; i < Dim; ++i)
+		{
+			normal[i] = m_Normals[i][p];
+			origin[i] = m_Normals[i][p] * m_Offsets[p];
+		}
+
+		return HyperplaneType(origin, normal);
+	}
+
+	template<typename T, size_t Dim, class Allocator>
+	inline bool ConvexPolytope<T, Dim, Allocator>::Contains(const Point<ValType, Dim>& point) const
+	{
+		bool inside = true;
+
+		for (size_t b = 0; b < m_Offsets.size(); b += LaneWidth)
+		{
+			ValType d[LaneWidth];
+
+			for (size_t j = 0; j < LaneWidth; ++j)
+				d[j] = -m_Offsets[b + j];
+
+			for (size_t i = 0; i < Dim; ++i)
+				for (size_t j = 0; j < LaneWidth; ++j)
+					d[j] += m_Normals[i][b + j] * point[i];
+
+			for (size_t j = 0; j < LaneWidth; ++j)
+				inside &= d[j] <= ValType(0);
+		}
+
+		return inside;
+	}
+
+	template<typename T, size_t Dim, class Allocator>
+	inline void ConvexPolytope<T, Dim, Allocator>::Project(const ValType* axis, ValType& min, ValType& max) const
+	{
+		min =  std::numeric_limits<ValType>::infinity();
+		max = -std::numeric_limits<ValType>::infinity();
+
+		if (m_ContainsLines)
+		{
+			min = -std::numeric_limits<ValType>::infinity();
+			max =  std::numeric_limits<ValType>::infinity();
+			return;
+		}
+
+		for (size_t v = 0; v < NumVertices(); ++v)
+		{
+			ValType d = ValType(0);
+
+			for (size_t i = 0; i < Dim; ++i)
+				d += axis[i] * m_Vertices[i][v];
+
+			min = std::min(min, d);
+			max = std::max(max, d);
+		}
+
+		ValType axisNorm = ValType(0);
+
+		for (size_t i = 0; i < Dim; ++i)
+			axisNorm += axis[i] * axis[i];
+
+		const ValType tolerance = DirectionRounding() * std::sqrt(axisNorm);
+
+		for (const auto& ray : m_Rays)
+		{
+			ValType d = ValType(0);
+
+			for (size_t i = 0; i < Dim; ++i)
+				d += axis[i] * ray[i];
+
+			if (d > tolerance)
+				max = std::numeric_limits<ValType>::infinity();
+
+			if (d < -tolerance)
+				min = -std::numeric_limits<ValType>::infinity();
+		}
+	}
+
+	/////////////////////////
+	//-- Collision tests --//
+	/////////////////////////
+
+	// Part of the line [tmin, tmax] inside the polytope, every plane of a block being clipped at once.
+	// Entry and exit face ids are NoFace when the range is not clipped on that side. Through an
+	// unbounded polytope the distance of such a side may be infinite, its point is then left null.
+	template<typename T, size_t Dim, class Allocator>
+	inline std::optional<ConvexPolytopeVSLine<T, Dim>>
+	ClipLine(
+		const ConvexPolytope<T, Dim, Allocator>& polytope,
+		const Line<T, Dim>& line,
+		T tmin = -std::numeric_limits<T>::infinity(),
+		T tmax =  std::numeric_limits<T>::infinity())
+	{
+		using ResultType       = ConvexPolytopeVSLine<T, Dim>;
+		using IntersectionType = typename ResultType::IntersectionType;
+
+		constexpr size_t LaneWidth = ConvexPolytope<T, Dim, Allocator>::LaneWidth;
+		constexpr size_t NoFace    = ResultType::NoFace;
+
+		// Per lane entry and exit, reduced across lanes at the end
+		T        tenter[LaneWidth], texit[LaneWidth];
+		uint32_t fenter[LaneWidth], fexit[LaneWidth];
+		bool     outside = false;
+
+		for (size_t j = 0; j < LaneWidth; ++j)
+		{
+			tenter[j] = tmin;
+			texit[j]  = tmax;
+			fenter[j] = uint32_t(-1);
+			fexit[j]  = uint32_t(-1);
+		}
+
+		const T* offsets = polytope.Offsets();
+
+		for (size_t block = 0; block < polytope.NumBlocks(); ++block)
+		{
+			const size_t base = block * LaneWidth;
+
+			// Distance of the origin behind the plane, and approach speed of the line
+			T behind[LaneWidth], speed[LaneWidth];
+
+			for (size_t j = 0; j < LaneWidth; ++j)
+			{
+				behind[j] = offsets[base + j];
+				speed[j]  = T(0);
+			}
+
+			for (size_t i = 0; i < Dim; ++i)
+			{
+				const T* normals = polytope.Normals(i) + base;
+
+				for (size_t j = 0; j < LaneWidth; ++j)
+				{
+					behind[j] -= normals[j] * line.Origin()[i];
+					speed[j]  += normals[j] * line.Direction()[i];
+				}
+			}
+
+			for (size_t j = 0; j < LaneWidth; ++j)
+			{
+				const T    t     = behind[j] / speed[j];
+				const bool enter = speed[j] < T(0);
+				const bool exit  = speed[j] > T(0);
+
+				// Parallel to a plane and in front of it
+				outside |= (speed[j] == T(0)) & (behind[j] < T(0));
+
+				const bool later   = enter & (t > tenter[j]);
+				const bool earlier = exit  & (t < texit[j]);
+
+				tenter[j] = later   ? t                  : tenter[j];
+				fenter[j] = later   ? uint32_t(base + j) : fenter[j];
+				texit[j]  = earlier ? t                  : texit[j];
+				fexit[j]  = earlier ? uint32_t(base + j) : fexit[j];
+			}
+		}
+
+		IntersectionType entry{ NoFace, HVectorND<T, Dim>(), tmin };
+		IntersectionType exit{ NoFace, HVectorND<T, Dim>(), tmax };
+
+		for (size_t j = 0; j < LaneWidth; ++j)
+		{
+			if (tenter[j] > entry.Distance)
+			{
+				entry.Distance = tenter[j];
+				entry.FaceId   = fenter[j];
+			}
+
+			if (texit[j] < exit.Distance)
+			{
+				exit.Distance = texit[j];
+				exit.FaceId   = fexit[j];
+			}
+		}
+
+		if (outside || entry.Distance >= exit.Distance)
+			return std::optional<ResultType>{ std::nullopt };
+
+		if (std::isfinite(entry.Distance))
+			entry.Point = entry.Distance * line.Direction() + line.Origin();
+
+		if (std::isfinite(exit.Distance))
+			exit.Point = exit.Distance * line.Direction() + line.Origin();
+
+		return std::optional<ResultType>{ std::in_place, entry, exit };
+	}
+
+	// ConvexPolytope vs Line intersection
+	template<typename T, size_t Dim, class Allocator>
+	inline std::optional<ConvexPolytopeVSLine<T, Dim>>
+	ComputeCollision(
+		const ConvexPolytope<T, Dim, Allocator>& polytope,
+		const Line<T, Dim>& line)
+	{
+		return ClipLine(polytope, line);
+	}
+
+	// AABB vs ConvexPolytope, conservative : false only if the box is in front of a plane
+	// or out of the bounds of the polytope, but true for some boxes close to its edges.
+	// One pass over the planes, LaneWidth at a time.
+	template<typename T, size_t Dim, class Allocator>
+	inline bool
+	DetectCollisionConservative(
+		const AABB<T, Dim>& aabb,
+		const ConvexPolytope<T, Dim, Allocator>& polytope)
+	{
+		constexpr size_t LaneWidth = ConvexPolytope<T, Dim, Allocator>::LaneWidth;
+
+		bool overlap = true;
+
+		for (size_t i = 0; i < Dim; ++i)
+			overlap &= (polytope.Min()[i] <= aabb.Max()[i]) & (aabb.Min()[i] <= polytope.Max()[i]);
+
+		const T* offsets = polytope.Offsets();
+
+		for (size_t block = 0; block < polytope.NumBlocks(); ++block)
+		{
+			const size_t base = block * LaneWidth;
+
+			// Signed distance of the corner of the box the furthest behind each plane
+			T d[LaneWidth];
+
+			for (size_t j = 0; j < LaneWidth; ++j)
+				d[j] = -offsets[base + j];
+
+			for (size_t i = 0; i < Dim; ++i)
+			{
+				const T* normals = polytope.Normals(i) + base;
+
+				for (size_t j = 0; j < LaneWidth; ++j)
+					d[j] += normals[j] * (normals[j] > T(0) ? aabb.Min()[i] : aabb.Max()[i]);
+			}
+
+			for (size_t j = 0; j < LaneWidth; ++j)
+				overlap &= d[j] <= T(0);
+		}
+
+		return overlap;
+	}
+
+	// AABB vs ConvexPolytope, exact (separating axis theorem) in 2D and 3D, unless the polytope contains lines.
+	// The face normals of both shapes are the conservative test, 3D adds the cross
+	// products of the axes with the edges of the polytope.
+	template<typename T, size_t Dim, class Allocator>
+	inline bool
+	DetectCollision(
+		const AABB<T, Dim>& aabb,
+		const ConvexPolytope<T, Dim, Allocator>& polytope)
+	{
+		static_assert(Dim == 2 || Dim == 3, "Exact AABB vs ConvexPolytope test is only available in 2D and 3D");
+
+		if (!DetectCollisionConservative(aabb, polytope))
+			return false;
+
+		if constexpr (Dim == 3)
+		{
+			T center[Dim], extent[Dim];
+
+			for (size_t i = 0; i < Dim; ++i)
+			{
+				center[i] = (aabb.Min()[i] + aabb.Max()[i]) / T(2);
+				extent[i] = (aabb.Max()[i] - aabb.Min()[i]) / T(2);
+			}
+
+			for (const auto& edge : polytope.EdgeDirections())
+			{
+				for (size_t k = 0; k < Dim; ++k)
+				{
+					// e_k x edge
+					T axis[Dim] = {};
+
+					axis[(k + 1) % 3] = -edge[(k + 2) % 3];
+					axis[(k + 2) % 3] =  edge[(k + 1) % 3];
+
+					T c = T(0), r = T(0);
+
+					for (size_t i = 0; i < Dim; ++i)
+					{
+						c += axis[i] * center[i];
+						r += std::abs(axis[i]) * extent[i];
+					}
+
+					T min, max;
+					polytope.Project(axis, min, max);
+
+					if (c + r < min || max < c - r)
+						return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	////////////////////////
+	//-- Shortcut types --//
+	////////////////////////
+
+	using ConvexPolytope2Df = ConvexPolytope<float, 2>;
+	using ConvexPolytope3Df = ConvexPolytope<float, 3>;
+}
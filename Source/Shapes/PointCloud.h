@@ -0,0 +1,142 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <utility>
+
+#include "LCN_Collisions/Source/Shapes/Point.h"
+#include "LCN_Collisions/Source/Memory/Allocator.h"
+
+namespace LCN
+{
+	/////////////////////
+	//-- Point cloud --//
+	/////////////////////
+
+	// Points stored as structure of arrays : one array per axis plus the id of every
+	// point (its insertion index), which follows the point when the cloud is partitioned.
+	template<typename T, size_t Dim, class Allocator = std::allocator<T>>
+	class PointCloud
+	{
+	public:
+		using ValType       = T;
+		using PointType     = Point<ValType, Dim>;
+		using RVectorType   = VectorND<ValType, Dim>;
+		using AllocatorType = Allocator;
+
+		explicit PointCloud(const Allocator& alloc = Allocator());
+
+		PointCloud(const std::vector<PointType>& points, const Allocator& alloc = Allocator());
+
+		void Reserve(size_t count);
+		void Clear();
+
+		void Add(const RVectorType& point);
+		void Add(const PointType& point);
+
+		size_t Size() const { return m_Ids.size(); }
+
+		PointType PointAt(size_t i) const;
+
+		      ValType* Coords(size_t axis)       { return m_Coords[axis].data(); }
+		const ValType* Coords(size_t axis) const { return m_Coords[axis].data(); }
+
+		      uint32_t* Ids()       { return m_Ids.data(); }
+		const uint32_t* Ids() const { return m_Ids.data(); }
+
+		void Swap(size_t i, size_t j);
+
+		const Allocator& GetAllocator() const { return m_Allocator; }
+
+	private:
+		Allocator m_Allocator;
+
+		std::array<AllocVector<ValType, Allocator>, Dim> m_Coords;
+		AllocVector<uint32_t, Allocator>                 m_Ids;
+	};
+
+	////////////////////////
+	//-- Implementation --//
+	////////////////////////
+
+	template<typename T, size_t Dim, class Allocator>
+	inline PointCloud<T, Dim, Allocator>::PointCloud(const Allocator& alloc) :
+		m_Allocator(alloc),
+		m_Coords(MakeVectorArray<ValType, Dim>(alloc)),
+		m_Ids(alloc)
+	{}
+
+	template<typename T, size_t Dim, class Allocator>
+	inline PointCloud<T, Dim, Allocator>::PointCloud(const std::vector<PointType>& points, const Allocator& alloc) :
+		PointCloud(alloc)
+	{
+		Reserve(points.size());
+
+		for (const PointType& point : points)
+			Add(point);
+	}
+
+	template<typename T, size_t Dim, class Allocator>
+	inline void PointCloud<T, Dim, Allocator>::Reserve(size_t count)
+	{
+		for (auto& coords : m_Coords)
+			coords.reserve(count);
+
+		m_Ids.reserve(count);
+	}
+
+	template<typename T, size_t Dim, class Allocator>
+	inline void PointCloud<T, Dim, Allocator>::Clear()
+	{
+		for (auto& coords : m_Coords)
+			coords.clear();
+
+		m_Ids.clear();
+	}
+
+	template<typename T, size_t Dim, class Allocator>
+	inline void PointCloud<T, Dim, Allocator>::Add(const RVectorType& point)
+	{
+		for (size_t i = 0; i < Dim; ++i)
+			m_Coords[i].push_back(point[i]);
+
+		m_Ids.push_back(uint32_t(m_Ids.size()));
+	}
+
+	template<typename T, size_t Dim, class Allocator>
+	inline void PointCloud<T, Dim, Allocator>::Add(const PointType& point)
+	{
+		for (size_t i = 0; i < Dim; ++i)
+			m_Coords[i].push_back(point[i]);
+
+		m_Ids.push_back(uint32_t(m_Ids.size()));
+	}
+
+	template<typename T, size_t Dim, class Allocator>
+	inline typename PointCloud<T, Dim, Allocator>::PointType PointCloud<T, Dim, Allocator>::PointAt(size_t idx) const
+	{
+		RVectorType point;
+
+		for (size_t i = 0; i < Dim; ++i)
+			point[i] = m_Coords[i][idx];
+
+		return PointType(point, ValType(1));
+	}
+
+	template<typename T, size_t Dim, class Allocator>
+	inline void PointCloud<T, Dim, Allocator>::Swap(size_t i, size_t j)
+	{
+		for (auto& coords : m_Coords)
+			std::swap(coords[i], coords[j]);
+
+		std::swap(m_Ids[i], m_Ids[j]);
+	}
+
+	////////////////////////
+	//-- Shortcut types --//
+	////////////////////////
+
+	using PointCloud2Df = PointCloud<float, 2>;
+	using PointCloud3Df = PointCloud<float, 3>;
+}
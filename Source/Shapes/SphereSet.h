@@ -0,0 +1,370 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <optional>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+
+#include <Utilities/Source/ErrorHandling.h>
+
+#include "LCN_Collisions/Source/Shapes/Sphere.h"
+#include "LCN_Collisions/Source/Shapes/Line.h"
+#include "LCN_Collisions/Source/Collisions/CollisionAlgorithms.h"
+#include "LCN_Collisions/Source/Core/Bits.h"
+#include "LCN_Collisions/Source/Memory/Allocator.h"
+
+namespace LCN
+{
+	template<typename T, size_t Dim, class Allocator = std::allocator<T>>
+	class SphereSet;
+
+	///////////////////////////
+	//-- SphereSet vs Line --//
+	///////////////////////////
+
+	template<typename T, size_t Dim>
+	class CollisionResult<SphereSet<T, Dim>, Line<T, Dim>>
+	{
+	public:
+		using ValType     = T;
+		using HVectorType = HVectorND<ValType, Dim>;
+
+		CollisionResult() = default;
+
+		CollisionResult(uint32_t sphereId, const HVectorType& inter, ValType coordinate) :
+			m_SphereId{ sphereId },
+			m_Intersection{ inter },
+			m_Coordinate{ coordinate }
+		{}
+
+		uint32_t SphereId() const { return m_SphereId; }
+
+		const HVectorType& Result() const { return m_Intersection; }
+
+		const ValType Coordinate() const { return m_Coordinate; }
+
+	private:
+		uint32_t    m_SphereId;
+		HVectorType m_Intersection;
+		ValType     m_Coordinate;
+	};
+
+	template<typename T, size_t Dim>
+	using SphereSetVSLine = CollisionResult<SphereSet<T, Dim>, Line<T, Dim>>;
+
+	// One entry of the all hits query
+	template<typename T>
+	struct SphereSetHit
+	{
+		uint32_t SphereId;
+		T        Distance1; // Entry
+		T        Distance2; // Exit
+	};
+
+	////////////////////
+	//-- Sphere set --//
+	////////////////////
+
+	// Spheres stored as structure of arrays, padded to a multiple of LaneWidth with
+	// spheres of negative square radius that can never be hit.
+	template<typename T, size_t Dim, class Allocator>
+	class SphereSet
+	{
+	public:
+		using ValType       = T;
+		using HVectorType   = HVectorND<ValType, Dim>;
+		using RVectorType   = VectorND<ValType, Dim>;
+		using SphereType    = SphereND<ValType, Dim>;
+		using HitType       = SphereSetHit<ValType>;
+		using AllocatorType = Allocator;
+
+		// One 512 bits register worth of lanes (16 floats, 8 doubles)
+		static constexpr size_t LaneWidth = 64 / sizeof(ValType);
+
+		explicit SphereSet(const Allocator& alloc = Allocator());
+
+		SphereSet(const std::vector<SphereType>& spheres, const Allocator& alloc = Allocator());
+
+		void Reserve(size_t count);
+		void Clear();
+
+		void Add(const RVectorType& center, ValType radius);
+		void Add(const SphereType& sphere);
+
+		void Set(size_t i, const RVectorType& center, ValType radius);
+
+		size_t Size() const { return m_Size; }
+
+		SphereType Sphere(size_t i) const;
+
+		// Padded arrays, NumBlocks() * LaneWidth long
+		const ValType* Centers(size_t axis) const { return m_Centers[axis].data(); }
+		const ValType* SquareRadii()        const { return m_SquareRadii.data(); }
+
+		size_t NumBlocks() const { return m_SquareRadii.size() / LaneWidth; }
+
+	private:
+		void Grow();
+
+		std::array<AllocVector<ValType, Allocator>, Dim> m_Centers;
+		AllocVector<ValType, Allocator>                 m_SquareRadii;
+
+		size_t m_Size = 0;
+	};
+
+	////////////////////////
+	//-- Implementation --//
+	////////////////////////
+
+	template<typename T, size_t Dim, class Allocator>
+	inline SphereSet<T, Dim, Allocator>::SphereSet(const Allocator& alloc) :
+		m_Centers(MakeVectorArray<ValType, Dim>(alloc)),
+		m_SquareRadii(alloc)
+	{}
+
+	template<typename T, size_t Dim, class Allocator>
+	inline SphereSet<T, Dim, Allocator>::SphereSet(const std::vector<SphereType>& spheres, const Allocator& alloc) :
+		SphereSet(alloc)
+	{
+		Reserve(spheres.size());
+
+		for (const SphereType& sphere : spheres)
+			Add(sphere);
+	}
+
+	template<typename T, size_t Dim, class Allocator>
+	inline void SphereSet<T, Dim, Allocator>::Reserve(size_t count)
+	{
+		count = (count + LaneWidth - 1) / LaneWidth * LaneWidth;
+
+		for (auto& centers : m_Centers)
+			centers.reserve(count);
+
+		m_SquareRadii.reserve(count);
+	}
+
+	template<typename T, size_t Dim, class Allocator>
+	inline void SphereSet<T, Dim, Allocator>::Clear()
+	{
+		for (auto& centers : m_Centers)
+			centers.clear();
+
+		m_SquareRadii.clear();
+		m_Size = 0;
+	}
+
+	template<typename T, size_t Dim, class Allocator>
+	inline void SphereSet<T, Dim, Allocator>::Grow()
+	{
+		// Padding spheres of radius -infinity are never hit
+		for (auto& centers : m_Centers)
+			centers.resize(centers.size() + LaneWidth, ValType(0));
+
+		m_SquareRadii.resize(m_SquareRadii.size() + LaneWidth, -std::numeric_limits<ValType>::infinity());
+	}
+
+	template<typename T, size_t Dim, class Allocator>
+	inline void SphereSet<T, Dim, Allocator>::Add(const RVectorType& center, ValType radius)
+	{
+		if (m_Size == m_SquareRadii.size())
+			Grow();
+
+		Set(m_Size++, center, radius);
+	}
+
+	template<typename T, size_t Dim, class Allocator>
+	inline void SphereSet<T, Dim, Allocator>::Add(const SphereType& sphere)
+	{
+		if (m_Size == m_SquareRadii.size())
+			Grow();
+
+		for (size_t i = 0; i < Dim; ++i)
+			m_Centers[i][m_Size] = sphere.Center()[i];
+
+		m_SquareRadii[m_Size++] = sphere.SquareRadius();
+	}
+
+	template<typename T, size_t Dim, class Allocator>
+	inline void SphereSet<T, Dim, Allocator>::Set(size_t idx, const RVectorType& center, ValType radius)
+	{
+		ASSERT(idx < m_Size);
+
+		for (size_t i = 0; i < Dim; ++i)
+			m_Centers[i][idx] = center[i];
+
+		m_SquareRadii[idx] = radius * radius;
+	}
+
+	template<typename T, size_t Dim, class Allocator>
+	inline typename SphereSet<T, Dim, Allocator>::SphereType SphereSet<T, Dim, Allocator>::Sphere(size_t idx) const
+	{
+		RVectorType center;
+
+		for (size_t i = 0; i < Dim; ++i)
+			center[i] = m_Centers[i][idx];
+
+		return SphereType(center, std::sqrt(m_SquareRadii[idx]));
+	}
+
+	///////////////////////////
+	//-- Collision queries --//
+	///////////////////////////
+
+	// Evaluates the discriminant of LaneWidth spheres of a block at once.
+	// Returns the mask of the lanes that are hit, padding lanes excluded, b and delta are filled for all lanes.
+	template<typename T, size_t Dim, class Allocator>
+	inline uint64_t
+	SphereBlockVSLine(
+		const SphereSet<T, Dim, Allocator>& set,
+		size_t block,
+		const T* origin,
+		const T* direction,
+		T* b,
+		T* delta)
+	{
+		constexpr size_t LaneWidth = SphereSet<T, Dim, Allocator>::LaneWidth;
+
+		const size_t base = block * LaneWidth;
+
+		T ocDotDir[LaneWidth] = {};
+		T ocSquare[LaneWidth] = {};
+
+		for (size_t i = 0; i < Dim; ++i)
+		{
+			const T* centers = set.Centers(i) + base;
+
+			for (size_t lane = 0; lane < LaneWidth; ++lane)
+			{
+				T oc = origin[i] - centers[lane];
+
+				ocDotDir[lane] += oc * direction[i];
+				ocSquare[lane] += oc * oc;
+			}
+		}
+
+		const T* squareRadii = set.SquareRadii() + base;
+
+		uint64_t mask = 0;
+
+		for (size_t lane = 0; lane < LaneWidth; ++lane)
+		{
+			b[lane]     = ocDotDir[lane];
+			delta[lane] = ocDotDir[lane] * ocDotDir[lane] - ocSquare[lane] + squareRadii[lane];
+
+			mask |= uint64_t(delta[lane] >= T(0)) << lane;
+		}
+
+		// Lanes past the last sphere of the set
+		const size_t valid = std::min(set.Size() - base, LaneWidth);
+
+		if (valid < LaneWidth)
+			mask &= (uint64_t(1) << valid) - 1;
+
+		return mask;
+	}
+
+	// SphereSet vs Line : closest sphere hit at a non negative distance
+	// (exit point when the origin is inside the sphere)
+	template<typename T, size_t Dim, class Allocator>
+	std::optional<SphereSetVSLine<T, Dim>>
+	ComputeCollision(
+		const SphereSet<T, Dim, Allocator>& set,
+		const Line<T, Dim>& line)
+	{
+		using ResultType = std::optional<SphereSetVSLine<T, Dim>>;
+
+		constexpr size_t LaneWidth = SphereSet<T, Dim, Allocator>::LaneWidth;
+
+		T origin[Dim], direction[Dim];
+
+		for (size_t i = 0; i < Dim; ++i)
+		{
+			origin[i]    = line.Origin()[i];
+			direction[i] = line.Direction()[i];
+		}
+
+		T        nearest   = std::numeric_limits<T>::infinity();
+		uint32_t nearestId = 0;
+
+		T b[LaneWidth], delta[LaneWidth];
+
+		for (size_t block = 0; block < set.NumBlocks(); ++block)
+		{
+			uint64_t mask = SphereBlockVSLine(set, block, origin, direction, b, delta);
+
+			// Square roots only for the lanes that are hit
+			ForEachSetBit(mask, [&](uint32_t lane)
+			{
+				T sqrtDelta = std::sqrt(delta[lane]);
+				T t1 = -b[lane] - sqrtDelta;
+				T t2 = -b[lane] + sqrtDelta;
+				T t  = t1 >= T(0) ? t1 : t2;
+
+				if (t >= T(0) && t < nearest)
+				{
+					nearest   = t;
+					nearestId = uint32_t(block * LaneWidth + lane);
+				}
+			});
+		}
+
+		if (nearest == std::numeric_limits<T>::infinity())
+			return ResultType{ std::nullopt };
+
+		return ResultType{ std::in_place, nearestId, nearest * line.Direction() + line.Origin(), nearest };
+	}
+
+	// SphereSet vs Line : every sphere crossed at a non negative distance, like ComputeCollision,
+	// compacted in hits (cleared first). Distance1 is negative when the origin is inside the sphere,
+	// spheres entirely behind the origin are not reported. Returns the number of hits.
+	template<typename T, size_t Dim, class Allocator, class HitAllocator>
+	size_t
+	ComputeCollisions(
+		const SphereSet<T, Dim, Allocator>& set,
+		const Line<T, Dim>& line,
+		std::vector<SphereSetHit<T>, HitAllocator>& hits)
+	{
+		constexpr size_t LaneWidth = SphereSet<T, Dim, Allocator>::LaneWidth;
+
+		T origin[Dim], direction[Dim];
+
+		for (size_t i = 0; i < Dim; ++i)
+		{
+			origin[i]    = line.Origin()[i];
+			direction[i] = line.Direction()[i];
+		}
+
+		hits.clear();
+
+		T b[LaneWidth], delta[LaneWidth];
+
+		for (size_t block = 0; block < set.NumBlocks(); ++block)
+		{
+			uint64_t mask = SphereBlockVSLine(set, block, origin, direction, b, delta);
+
+			ForEachSetBit(mask, [&](uint32_t lane)
+			{
+				T sqrtDelta = std::sqrt(delta[lane]);
+				T t2 = -b[lane] + sqrtDelta;
+
+				if (t2 >= T(0))
+					hits.push_back(SphereSetHit<T>{ uint32_t(block * LaneWidth + lane), -b[lane] - sqrtDelta, t2 });
+			});
+		}
+
+		return hits.size();
+	}
+
+	////////////////////////
+	//-- Shortcut types --//
+	////////////////////////
+
+	using CircleSet2Df = SphereSet<float, 2>;
+	using SphereSet3Df = SphereSet<float, 3>;
+
+	using CircleSetVSLine2Df = SphereSetVSLine<float, 2>;
+	using SphereSetVSLine3Df = SphereSetVSLine<float, 3>;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <utility>
+#include <type_traits>
+
+#include <LCN_Math/Source/Geometry/Geometry.h>
+
+namespace LCN
+{
+	//////////////////
+	//-- Triangle --//
+	//////////////////
+
+	template<typename T>
+	class Triangle
+	{
+	public:
+		using ValType     = T;
+		using HVectorType = HVectorND<ValType, 3>;
+		using RVectorType = VectorND<ValType, 3>;
+
+		Triangle() = default;
+
+		Triangle(const RVectorType& v0, const RVectorType& v1, const RVectorType& v2) :
+			m_Vertices{ HVectorType(v0, ValType(1)), HVectorType(v1, ValType(1)), HVectorType(v2, ValType(1)) }
+		{}
+
+		inline const HVectorType& operator[](size_t i) const { return m_Vertices[i]; }
+		inline       HVectorType& operator[](size_t i)       { return m_Vertices[i]; }
+
+	private:
+		std::array<HVectorType, 3> m_Vertices;
+	};
+
+	//////////////////////////////////////////
+	//-- Ray setup for watertight testing --//
+	//////////////////////////////////////////
+
+	// Per ray constants of the watertight ray/triangle test (Woop, Benthin, Wald 2013).
+	// The ray is permuted so that its dominant axis is z, then sheared so that it
+	// becomes the +z axis : edge functions are then evaluated in 2D and shared
+	// edges are never missed nor hit twice.
+	template<typename T>
+	struct WatertightRay
+	{
+		using ValType = T;
+
+		template<class LineType>
+		explicit WatertightRay(const LineType& line)
+		{
+			const auto& d = line.Direction();
+
+			Kz = 0;
+			for (size_t i = 1; i < 3; ++i)
+				if (std::abs(d[i]) > std::abs(d[Kz]))
+					Kz = i;
+
+			Kx = (Kz + 1) % 3;
+			Ky = (Kx + 1) % 3;
+
+			if (d[Kz] < ValType(0))
+				std::swap(Kx, Ky);
+
+			Sx = d[Kx] / d[Kz];
+			Sy = d[Ky] / d[Kz];
+			Sz = ValType(1) / d[Kz];
+
+			for (size_t i = 0; i < 3; ++i)
+				Origin[i] = line.Origin()[i];
+		}
+
+		// a, b, c : triangle vertices (x, y, z)
+		// On hit, t is the distance along the line and (u, v) the barycentric weights of b and c
+		bool Intersect(const ValType* a, const ValType* b, const ValType* c, ValType& t, ValType& u, ValType& v) const
+		{
+			const ValType Ax = (a[Kx] - Origin[Kx]) - Sx * (a[Kz] - Origin[Kz]);
+			const ValType Ay = (a[Ky] - Origin[Ky]) - Sy * (a[Kz] - Origin[Kz]);
+			const ValType Bx = (b[Kx] - Origin[Kx]) - Sx * (b[Kz] - Origin[Kz]);
+			const ValType By = (b[Ky] - Origin[Ky]) - Sy * (b[Kz] - Origin[Kz]);
+			const ValType Cx = (c[Kx] - Origin[Kx]) - Sx * (c[Kz] - Origin[Kz]);
+			const ValType Cy = (c[Ky] - Origin[Ky]) - Sy * (c[Kz] - Origin[Kz]);
+
+			ValType U = Cx * By - Cy * Bx;
+			ValType V = Ax * Cy - Ay * Cx;
+			ValType W = Bx * Ay - By * Ax;
+
+			// Edge exactly hit : recompute in double precision
+			if constexpr (std::is_same_v<ValType, float>)
+			{
+				if (U == ValType(0) || V == ValType(0) || W == ValType(0))
+				{
+					U = ValType(double(Cx) * double(By) - double(Cy) * double(Bx));
+					V = ValType(double(Ax) * double(Cy) - double(Ay) * double(Cx));
+					W = ValType(double(Bx) * double(Ay) - double(By) * double(Ax));
+				}
+			}
+
+			if ((U < ValType(0) || V < ValType(0) || W < ValType(0)) &&
+				(U > ValType(0) || V > ValType(0) || W > ValType(0)))
+				return false;
+
+			const ValType det = U + V + W;
+
+			if (det == ValType(0))
+				return false;
+
+			const ValType Az = Sz * (a[Kz] - Origin[Kz]);
+			const ValType Bz = Sz * (b[Kz] - Origin[Kz]);
+			const ValType Cz = Sz * (c[Kz] - Origin[Kz]);
+
+			const ValType invDet = ValType(1) / det;
+
+			t = (U * Az + V * Bz + W * Cz) * invDet;
+			u = V * invDet;
+			v = W * invDet;
+
+			return true;
+		}
+
+		size_t Kx, Ky, Kz;
+
+		ValType Sx, Sy, Sz;
+
+		std::array<ValType, 3> Origin;
+	};
+
+	////////////////////////
+	//-- Shortcut types --//
+	////////////////////////
+
+	using Triangle3Df = Triangle<float>;
+	using Triangle3Dd = Triangle<double>;
+}
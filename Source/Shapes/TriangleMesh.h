@@ -0,0 +1,420 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <optional>
+#include <limits>
+#include <cstdint>
+
+#include "LCN_Collisions/Source/Shapes/Triangle.h"
+#include "LCN_Collisions/Source/Acceleration/BVH.h"
+#include "LCN_Collisions/Source/Collisions/CollisionAlgorithms.h"
+#include "LCN_Collisions/Source/Memory/Allocator.h"
+
+namespace LCN
+{
+	template<typename T, class Allocator = std::allocator<T>>
+	class TriangleMesh;
+
+	////////////////////////////////////////
+	//-- TriangleMesh vs Line (3D only) --//
+	////////////////////////////////////////
+
+	template<typename T>
+	class CollisionResult<TriangleMesh<T>, Line<T, 3>>
+	{
+	public:
+		using ValType     = T;
+		using HVectorType = HVectorND<ValType, 3>;
+
+		CollisionResult() = default;
+
+		CollisionResult(uint32_t triangleId, const HVectorType& inter, ValType coordinate, ValType u, ValType v) :
+			m_TriangleId{ triangleId },
+			m_Intersection{ inter },
+			m_Coordinate{ coordinate },
+			m_U{ u },
+			m_V{ v }
+		{}
+
+		// Index of the triangle in the array given at construction
+		uint32_t TriangleId() const { return m_TriangleId; }
+
+		const HVectorType& Result() const { return m_Intersection; }
+
+		const ValType Coordinate() const { return m_Coordinate; }
+
+		const ValType U() const { return m_U; }
+		const ValType V() const { return m_V; }
+
+	private:
+		uint32_t    m_TriangleId;
+		HVectorType m_Intersection;
+		ValType     m_Coordinate;
+		ValType     m_U;
+		ValType     m_V;
+	};
+
+	template<typename T>
+	using TriangleMeshVSLine = CollisionResult<TriangleMesh<T>, Line<T, 3>>;
+
+	///////////////////////
+	//-- Triangle mesh --//
+	///////////////////////
+
+	// Indexed, static triangle mesh with its own BVH.
+	// At construction triangles are reordered in BVH leaf order and vertices in first
+	// use order, so that a leaf touches contiguous memory. Triangles are also copied in
+	// SoA packets of LaneWidth triangles for the multi triangle leaf test, every leaf
+	// starting a new packet so that a leaf of up to LaneWidth triangles is one packet.
+	template<typename T, class Allocator>
+	class TriangleMesh
+	{
+	public:
+		using ValType       = T;
+		using AllocatorType = Allocator;
+		using HVectorType  = HVectorND<ValType, 3>;
+		using RVectorType  = VectorND<ValType, 3>;
+		using IndexType    = std::array<uint32_t, 3>;
+		using VertexType   = std::array<ValType, 3>;
+		using TriangleType = Triangle<ValType>;
+		using AABBType     = AABB<ValType, 3>;
+		using LineType     = Line<ValType, 3>;
+		using BVHType      = BVH<ValType, 3, Allocator>;
+
+		// One 256 bits register worth of lanes
+		static constexpr size_t LaneWidth = 32 / sizeof(ValType);
+
+		enum class LeafTest
+		{
+			Scalar,
+			Packet
+		};
+
+		// LaneWidth triangles, indexed as [vertex][axis][lane]
+		struct alignas(32) TrianglePacket
+		{
+			ValType V[3][3][LaneWidth];
+		};
+
+		TriangleMesh(const std::vector<RVectorType>& vertices, const std::vector<IndexType>& triangles, size_t maxLeafSize = LaneWidth, const Allocator& alloc = Allocator());
+
+		size_t NumTriangles() const { return m_Triangles.size(); }
+		size_t NumVertices()  const { return m_Vertices.size(); }
+
+		// Triangles and vertices are in their reordered layout
+		const AllocVector<VertexType, Allocator>& Vertices()  const { return m_Vertices; }
+		const AllocVector<IndexType, Allocator>&  Triangles() const { return m_Triangles; }
+
+		// Original index of the triangle stored at slot
+		uint32_t TriangleId(size_t slot) const { return m_Hierarchy.Indices()[slot]; }
+
+		TriangleType TriangleAt(size_t slot) const;
+
+		const BVHType& Hierarchy() const { return m_Hierarchy; }
+
+		LeafTest LeafTestMode() const { return m_LeafTest; }
+		void     LeafTestMode(LeafTest mode) { m_LeafTest = mode; }
+
+		template<typename U, class UAllocator>
+		friend
+		std::optional<TriangleMeshVSLine<U>>
+		ComputeCollision(
+			const TriangleMesh<U, UAllocator>&,
+			const Line<U, 3>&);
+
+	private:
+		// Closest hit in the slots [first, first + count) with t in [tmin, tmax)
+		bool IntersectScalar(const WatertightRay<ValType>& ray, uint32_t first, uint32_t count, ValType tmin, ValType& tmax, uint32_t& slot, ValType& u, ValType& v) const;
+		bool IntersectPacket(const WatertightRay<ValType>& ray, uint32_t first, uint32_t count, ValType tmin, ValType& tmax, uint32_t& slot, ValType& u, ValType& v) const;
+
+		AllocVector<VertexType, Allocator>     m_Vertices;
+		AllocVector<IndexType, Allocator>      m_Triangles;
+		AllocVector<TrianglePacket, Allocator> m_Packets;
+		AllocVector<uint32_t, Allocator>       m_LeafPackets; // First packet of the leaf starting at a slot
+
+		BVHType  m_Hierarchy;
+		LeafTest m_LeafTest = LeafTest::Packet;
+	};
+
+	////////////////////////
+	//-- Implementation --//
+	////////////////////////
+
+	template<typename T, class Allocator>
+	inline TriangleMesh<T, Allocator>::TriangleMesh(const std::vector<RVectorType>& vertices, const std::vector<IndexType>& triangles, size_t maxLeafSize, const Allocator& alloc) :
+		m_Vertices(alloc),
+		m_Triangles(alloc),
+		m_Packets(alloc),
+		m_LeafPackets(alloc),
+		m_Hierarchy(alloc)
+	{
+		AllocVector<AABBType, Allocator> boxes(alloc);
+		boxes.reserve(triangles.size());
+
+		for (const IndexType& tri : triangles)
+		{
+			RVectorType min, max;
+
+			for (size_t i = 0; i < 3; ++i)
+			{
+				min[i] = std::min({ vertices[tri[0]][i], vertices[tri[1]][i], vertices[tri[2]][i] });
+				max[i] = std::max({ vertices[tri[0]][i], vertices[tri[1]][i], vertices[tri[2]][i] });
+			}
+
+			boxes.emplace_back(min, max);
+		}
+
+		m_Hierarchy.Build(boxes, maxLeafSize);
+
+		// Triangles in leaf order, vertices in first use order
+		const uint32_t unused = std::numeric_limits<uint32_t>::max();
+
+		AllocVector<uint32_t, Allocator> remap(vertices.size(), unused, alloc);
+
+		m_Triangles.resize(triangles.size());
+		m_Vertices.reserve(vertices.size());
+
+		for (size_t slot = 0; slot < triangles.size(); ++slot)
+		{
+			const IndexType& tri = triangles[m_Hierarchy.Indices()[slot]];
+
+			for (size_t k = 0; k < 3; ++k)
+			{
+				if (remap[tri[k]] == unused)
+				{
+					remap[tri[k]] = uint32_t(m_Vertices.size());
+					m_Vertices.push_back(VertexType{ vertices[tri[k]][0], vertices[tri[k]][1], vertices[tri[k]][2] });
+				}
+
+				m_Triangles[slot][k] = remap[tri[k]];
+			}
+		}
+
+		// SoA packets, leaves padded to a packet boundary, unused lanes are degenerate triangles
+		m_LeafPackets.resize(m_Triangles.size());
+
+		size_t numPackets = 0;
+
+		for (const auto& node : m_Hierarchy.Nodes())
+		{
+			if (!node.IsLeaf())
+				continue;
+
+			m_LeafPackets[node.Offset] = uint32_t(numPackets);
+			numPackets += (node.Count + LaneWidth - 1) / LaneWidth;
+		}
+
+		m_Packets.resize(numPackets);
+
+		for (TrianglePacket& packet : m_Packets)
+			for (size_t k = 0; k < 3; ++k)
+				for (size_t i = 0; i < 3; ++i)
+					for (size_t lane = 0; lane < LaneWidth; ++lane)
+						packet.V[k][i][lane] = ValType(0);
+
+		for (const auto& node : m_Hierarchy.Nodes())
+		{
+			if (!node.IsLeaf())
+				continue;
+
+			for (size_t n = 0; n < node.Count; ++n)
+			{
+				const size_t slot = node.Offset + n;
+
+				TrianglePacket& packet = m_Packets[m_LeafPackets[node.Offset] + n / LaneWidth];
+
+				for (size_t k = 0; k < 3; ++k)
+					for (size_t i = 0; i < 3; ++i)
+						packet.V[k][i][n % LaneWidth] = m_Vertices[m_Triangles[slot][k]][i];
+			}
+		}
+	}
+
+	template<typename T, class Allocator>
+	inline typename TriangleMesh<T, Allocator>::TriangleType TriangleMesh<T, Allocator>::TriangleAt(size_t slot) const
+	{
+		RVectorType v[3];
+
+		for (size_t k = 0; k < 3; ++k)
+			for (size_t i = 0; i < 3; ++i)
+				v[k][i] = m_Vertices[m_Triangles[slot][k]][i];
+
+		return TriangleType(v[0], v[1], v[2]);
+	}
+
+	template<typename T, class Allocator>
+	inline bool TriangleMesh<T, Allocator>::IntersectScalar(const WatertightRay<ValType>& ray, uint32_t first, uint32_t count, ValType tmin, ValType& tmax, uint32_t& slot, ValType& u, ValType& v) const
+	{
+		bool hit = false;
+
+		for (uint32_t s = first; s < first + count; ++s)
+		{
+			const IndexType& tri = m_Triangles[s];
+
+			ValType t, tu, tv;
+
+			if (!ray.Intersect(m_Vertices[tri[0]].data(), m_Vertices[tri[1]].data(), m_Vertices[tri[2]].data(), t, tu, tv))
+				continue;
+
+			if (t < tmin || t >= tmax)
+				continue;
+
+			tmax = t;
+			slot = s;
+			u    = tu;
+			v    = tv;
+			hit  = true;
+		}
+
+		return hit;
+	}
+
+	template<typename T, class Allocator>
+	inline bool TriangleMesh<T, Allocator>::IntersectPacket(const WatertightRay<ValType>& ray, uint32_t first, uint32_t count, ValType tmin, ValType& tmax, uint32_t& slot, ValType& u, ValType& v) const
+	{
+		const size_t kx = ray.Kx, ky = ray.Ky, kz = ray.Kz;
+
+		const ValType ox = ray.Origin[kx], oy = ray.Origin[ky], oz = ray.Origin[kz];
+		const ValType sx = ray.Sx, sy = ray.Sy, sz = ray.Sz;
+
+		bool hit = false;
+
+		// first is always the first slot of a leaf
+		const TrianglePacket* packets = m_Packets.data() + m_LeafPackets[first];
+
+		for (uint32_t base = 0; base < count; base += uint32_t(LaneWidth))
+		{
+			const TrianglePacket& packet = packets[base / LaneWidth];
+
+			alignas(32) ValType U[LaneWidth], V[LaneWidth], W[LaneWidth], Dist[LaneWidth];
+			alignas(32) bool    Valid[LaneWidth];
+
+			// Edge functions of all the lanes at once, this loop has no branch
+			for (size_t lane = 0; lane < LaneWidth; ++lane)
+			{
+				const ValType az = packet.V[0][kz][lane] - oz;
+				const ValType bz = packet.V[1][kz][lane] - oz;
+				const ValType cz = packet.V[2][kz][lane] - oz;
+
+				const ValType ax = (packet.V[0][kx][lane] - ox) - sx * az;
+				const ValType ay = (packet.V[0][ky][lane] - oy) - sy * az;
+				const ValType bx = (packet.V[1][kx][lane] - ox) - sx * bz;
+				const ValType by = (packet.V[1][ky][lane] - oy) - sy * bz;
+				const ValType cx = (packet.V[2][kx][lane] - ox) - sx * cz;
+				const ValType cy = (packet.V[2][ky][lane] - oy) - sy * cz;
+
+				const ValType eu = cx * by - cy * bx;
+				const ValType ev = ax * cy - ay * cx;
+				const ValType ew = bx * ay - by * ax;
+
+				const ValType det = eu + ev + ew;
+				const ValType dist = (eu * az + ev * bz + ew * cz) * sz / det;
+
+				const bool inside =
+					(eu >= ValType(0) && ev >= ValType(0) && ew >= ValType(0)) ||
+					(eu <= ValType(0) && ev <= ValType(0) && ew <= ValType(0));
+
+				U[lane]     = eu;
+				V[lane]     = ev;
+				W[lane]     = ew;
+				Dist[lane]  = dist;
+				Valid[lane] = inside && det != ValType(0) && dist >= tmin && dist < tmax;
+			}
+
+			// Padding lanes of the last packet are skipped
+			const size_t hi = std::min<size_t>(count - base, LaneWidth);
+
+			for (size_t lane = 0; lane < hi; ++lane)
+			{
+				// An edge is exactly hit, let the scalar test settle it
+				if (U[lane] == ValType(0) || V[lane] == ValType(0) || W[lane] == ValType(0))
+				{
+					hit |= IntersectScalar(ray, first + base + uint32_t(lane), 1, tmin, tmax, slot, u, v);
+					continue;
+				}
+
+				if (!Valid[lane] || Dist[lane] >= tmax)
+					continue;
+
+				const ValType det = U[lane] + V[lane] + W[lane];
+
+				tmax = Dist[lane];
+				slot = first + base + uint32_t(lane);
+				u    = V[lane] / det;
+				v    = W[lane] / det;
+				hit  = true;
+			}
+		}
+
+		return hit;
+	}
+
+	///////////////////////////
+	//-- Collision queries --//
+	///////////////////////////
+
+	// TriangleMesh vs Line : closest intersection with a non negative distance
+	template<typename T, class Allocator>
+	std::optional<TriangleMeshVSLine<T>>
+	ComputeCollision(
+		const TriangleMesh<T, Allocator>& mesh,
+		const Line<T, 3>& line)
+	{
+		using ResultType = std::optional<TriangleMeshVSLine<T>>;
+		using MeshType   = TriangleMesh<T, Allocator>;
+
+		const WatertightRay<T> ray(line);
+
+		bool     hit  = false;
+		uint32_t slot = 0;
+		T        dist = std::numeric_limits<T>::infinity();
+		T        u = 0, v = 0;
+
+		mesh.m_Hierarchy.Traverse(line, T(0), dist, [&](uint32_t first, uint32_t count, T& tmax)
+		{
+			if (mesh.m_LeafTest == MeshType::LeafTest::Packet)
+				hit |= mesh.IntersectPacket(ray, first, count, T(0), tmax, slot, u, v);
+			else
+				hit |= mesh.IntersectScalar(ray, first, count, T(0), tmax, slot, u, v);
+
+			dist = tmax;
+
+			return true;
+		});
+
+		if (!hit)
+			return ResultType{ std::nullopt };
+
+		return ResultType{ std::in_place, mesh.TriangleId(slot), dist * line.Direction() + line.Origin(), dist, u, v };
+	}
+
+	// AABB vs TriangleMesh
+	template<typename T, class Allocator>
+	inline bool
+	DetectCollision(
+		const AABB<T, 3>& aabb,
+		const TriangleMesh<T, Allocator>& mesh)
+	{
+		bool found = false;
+
+		mesh.Hierarchy().Traverse(aabb, [&](uint32_t first, uint32_t count)
+		{
+			for (uint32_t slot = first; slot < first + count && !found; ++slot)
+				found = DetectCollision(aabb, mesh.TriangleAt(slot));
+
+			return !found;
+		});
+
+		return found;
+	}
+
+	////////////////////////
+	//-- Shortcut types --//
+	////////////////////////
+
+	using TriangleMesh3Df = TriangleMesh<float>;
+	using TriangleMesh3Dd = TriangleMesh<double>;
+
+	using TriangleMeshVSLine3Df = TriangleMeshVSLine<float>;
+}